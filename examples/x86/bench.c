@@ -0,0 +1,395 @@
+/* vi:set ts=4: <-- vi tabstop
+   bench.c - time s16math functions over their input domain.
+   Copyright (c) 2014 Bryan Batten <bjbatten@acm.org>
+
+   Sweeps all 65536 arguments of each unary function and a grid of
+   arguments for each binary function, and times the array functions on
+   65536 elements. Prints one JSON object on stdout: ns per call, the
+   slowest argument found, for array functions ns and time stamp counter
+   ticks per element, for s16_root() ns per call at each of a set of
+   indices, the memo cache hit and miss counts, and for the reduced
+   precision functions ns per call and error at each setting.
+ */
+#include <stdio.h>		/* for printf */
+#include <stdlib.h>		/* for atoi () */
+#include <getopt.h>		/* for getopt () */
+#include <string.h>		/* for GNU strrchr () */
+#include "bench.h"		/* for function tables, timing */
+
+/* set program name */
+#define	setpn(p)							\
+		if (!((p) = strrchr(argv[0], '/')))	\
+			(p) = argv[0];					\
+		else (p)++
+
+#define MEMO_BITS	10				/* memo cache entries, log2 */
+#define GAMMA		(UI*10/22)		/* 1/2.2 */
+
+static char *pname;
+static double tsc_ns;			/* time stamp counter ticks per ns */
+static u64 overhead;			/* ticks to time NCALLS empty calls */
+static s16 xa[NARGS],xb[NARGS],xr[NARGS],xs[NARGS];
+static s16 xiq[2*NARGS];		/* xa and xb interleaved */
+static s16 xriq[2*NARGS];		/* interleaved results */
+
+/* s16_root() indices timed over every radicand */
+static const s16 root_index[]={
+	UI/2, 3*UI/2, 2*UI, 3*UI, 4*UI, 5*UI, 7*UI, 16*UI, 100*UI, 255*UI, -2*UI,
+	-3*UI
+};
+
+static void usage ()
+{
+	fprintf(stderr, "Usage:\t\"%s[ -r reps][ -g step][ -f name] where:\n"
+		"\t-r times each sweep is repeated; the fastest counts (3).\n"
+		"\t-g grid step for binary function arguments (257).\n"
+		"\t-f times only functions whose name contains name.\n"
+		, pname);
+}
+
+/* ns per call of NCALLS calls taking c ticks */
+static double callns(u64 c)
+{
+	c=c > overhead?c-overhead:0;
+	return c/tsc_ns/NCALLS;
+
+} /* End callns () */
+
+static void bench_unary(int i, int reps)
+{
+	unary_fn fn=unary[i].fn;
+	u64 best=~0ull,c,worst=0;
+	u32 x;
+	s16 wx=0;
+	int r;
+
+	/* fill a lazily filled table before the timed passes */
+	sink=fn(0);
+	for (r=0; r<reps; r++) {
+		c=__rdtsc();
+		for (x=0; x<NARGS; x++)
+			sink=fn((s16)x);
+		c=__rdtsc()-c;
+		if (c < best)
+			best=c;
+	}
+	for (x=0; x<NARGS; x++)
+		if ((c=time1(fn,(s16)x)) > worst) {
+			worst=c;
+			wx=(s16)x;
+		}
+	printf("    {\"name\": \"%s\", \"calls\": %u, \"ns_per_call\": %.2f, "
+		   "\"worst_input\": %d, \"worst_ns\": %.2f}",
+		   unary[i].name,NARGS,best/tsc_ns/NARGS,wx,callns(worst));
+
+} /* End bench_unary () */
+
+static void bench_binary(int i, int reps, int step)
+{
+	binary_fn fn=binary[i].fn;
+	u64 best=~0ull,c,worst=0;
+	s32 a,b;
+	s16 wa=0,wb=0;
+	u32 n=0;
+	int r;
+
+	for (r=0; r<reps; r++) {
+		n=0;
+		c=__rdtsc();
+		for (a=-32768; a<32768; a+=step)
+			for (b=-32768; b<32768; b+=step, n++)
+				sink=fn(a,b);
+		c=__rdtsc()-c;
+		if (c < best)
+			best=c;
+	}
+	for (a=-32768; a<32768; a+=step)
+		for (b=-32768; b<32768; b+=step)
+			if ((c=time2(fn,a,b)) > worst) {
+				worst=c;
+				wa=a;
+				wb=b;
+			}
+	printf("    {\"name\": \"%s\", \"calls\": %u, \"grid_step\": %d, "
+		   "\"ns_per_call\": %.2f, \"worst_input\": [%d, %d], "
+		   "\"worst_ns\": %.2f}",
+		   binary[i].name,n,step,best/tsc_ns/n,wa,wb,callns(worst));
+
+} /* End bench_binary () */
+
+/* Reduced precision functions, each called as fn(a,b,setting) */
+typedef s32 prec_fn(s16 a, s16 b, u8 p);
+static s32 prec_sincos(s16 a, s16 b, u8 p) { return s16_sincos_p(a,p); }
+static s32 prec_atan(s16 a, s16 b, u8 p) { return s16_atan_p(a,p); }
+static s32 prec_atan2(s16 a, s16 b, u8 p) { return s16_atan2_p(b,a,p); }
+static s32 prec_ln(s16 a, s16 b, u8 p) { return s16_ln_p(a,p); }
+
+static const struct {
+	const char	*name;
+	prec_fn		*fn;
+	s32			lo,hi;		/* first operand range */
+	u8			binary;		/* second operand swept on the grid too */
+	u8			pair;		/* cos and sin packed as sincos_t */
+	u8			full;		/* setting giving full precision */
+} prec[]={
+	{ "s16_sincos_p", prec_sincos, 0, S16_RAD, 0, 1, NUM_CORDIC_ENTRIES },
+	{ "s16_atan_p", prec_atan, -32768, 32768, 0, 0, NUM_CORDIC_ENTRIES },
+	{ "s16_atan2_p", prec_atan2, -32768, 32768, 1, 0, NUM_CORDIC_ENTRIES },
+	{ "s16_ln_p", prec_ln, 1, 32768, 0, 0, 2 },
+};
+
+/* greatest difference of r from the full precision result f */
+static s32 prec_err(s32 r, s32 f, u8 pair)
+{
+	sincos_t a,b;
+	s32 e;
+
+	if (!pair)
+		return abs(r-f);
+	a.sincos=r;
+	b.sincos=f;
+	e=abs(a.s.cos-b.s.cos);
+	return e > abs(a.s.sin-b.s.sin)?e:abs(a.s.sin-b.s.sin);
+
+} /* End prec_err () */
+
+/* prec[i] at each setting: ns per call, and the greatest difference from
+   the full precision result in least significant bits */
+static void bench_prec(int i, int reps, int step, const char *sep)
+{
+	prec_fn *fn=prec[i].fn;
+	s32 a,b,bstep=prec[i].binary?step:1<<16,e,worst;
+	u64 best,c;
+	u32 n=0;
+	int r;
+	u8 p;
+
+	if (!prec[i].binary)
+		step=1;
+	for (p=0; p<=prec[i].full; p++) {
+		best=~0ull;
+		for (r=0; r<reps; r++) {
+			n=0;
+			c=__rdtsc();
+			for (a=prec[i].lo; a<prec[i].hi; a+=step)
+				for (b=prec[i].binary?-32768:0; b<32768; b+=bstep, n++)
+					sink=fn(a,b,p);
+			c=__rdtsc()-c;
+			if (c < best)
+				best=c;
+		}
+		worst=0;
+		for (a=prec[i].lo; a<prec[i].hi; a+=step)
+			for (b=prec[i].binary?-32768:0; b<32768; b+=bstep)
+				if ((e=prec_err(fn(a,b,p),fn(a,b,prec[i].full),
+								prec[i].pair)) > worst)
+					worst=e;
+		printf("%s    {\"name\": \"%s\", \"setting\": %d, \"calls\": %u, "
+			   "\"ns_per_call\": %.2f, \"max_err\": %d}",
+			   sep,prec[i].name,p,n,best/tsc_ns/n,worst);
+		sep=",\n";
+	}
+
+} /* End bench_prec () */
+
+/* a^n by n-1 s16_mul() calls, as the prebuilt s16_pow() runs it */
+static s16 mul_chain(s16 a, int n)
+{
+	s16 r=a;
+
+	while (--n > 0)
+		r=s16_mul(r,a);
+	return r;
+
+} /* End mul_chain () */
+
+/* s16_root() at index n over every radicand */
+static void bench_root(s16 n, int reps)
+{
+	u64 best=~0ull,c,worst=0;
+	u32 x;
+	s16 wx=0;
+	int r;
+
+	for (r=0; r<reps; r++) {
+		c=__rdtsc();
+		for (x=0; x<NARGS; x++)
+			sink=s16_root((s16)x,n);
+		c=__rdtsc()-c;
+		if (c < best)
+			best=c;
+	}
+	for (x=0; x<NARGS; x++)
+		if ((c=time2(call_s16_root,(s16)x,n)) > worst) {
+			worst=c;
+			wx=(s16)x;
+		}
+	printf("    {\"index\": %d, \"value\": %.2f, \"ns_per_call\": %.2f, "
+		   "\"worst_input\": %d, \"worst_ns\": %.2f}",
+		   n,(double)n/UI,best/tsc_ns/NARGS,wx,callns(worst));
+
+} /* End bench_root () */
+
+/* time one array call of NARGS elements */
+#define BATCH(name,call)						\
+	if (!filter || strstr(name,filter)) {		\
+		best=~0ull;								\
+		for (r=0; r<reps; r++) {				\
+			c=__rdtsc();						\
+			call;								\
+			c=__rdtsc()-c;						\
+			if (c < best)						\
+				best=c;							\
+		}										\
+		printf("%s    {\"name\": \"%s\", \"elements\": %u, "			\
+			   "\"ns_per_element\": %.3f, \"tsc_ticks_per_element\": %.2f}",\
+			   sep,name,NARGS,best/tsc_ns/NARGS,(double)best/NARGS);	\
+		sep=",\n";								\
+	}
+
+int main(int argc, char *argv[]) {
+	int	chr,reps=3,step=257,i,r;
+	const char *filter=NULL,*sep;
+	s16_nco_t nco;
+	s16_divider_t dv;
+	s16_powexp_t pe;
+	s16_logbase_t lb;
+	u64 best,c;
+	u32 x,hits,misses;
+
+	setpn(pname);
+
+	/* Get program options. */
+	while ((chr = getopt( argc, argv, "r:g:f:h?")) != EOF ) {
+		switch (chr) {
+		case 'r':
+			reps=atoi(optarg);
+			break;
+		case 'g':
+			step=atoi(optarg);
+			break;
+		case 'f':
+			filter=optarg;
+			break;
+		case 'h':
+		case '?':
+			usage ();
+			exit (0);
+		default :
+			fprintf( stderr, "%s: Unknown option: '%c'\n", pname, chr );
+			usage ();
+			exit (1);
+		}
+	} /* End option scan */
+	if (reps < 1 || step < 1) {
+		usage ();
+		exit (1);
+	}
+
+	if (s16_memo_init(MEMO_BITS)) {
+		fprintf(stderr,"%s: no memory for the memo cache\n",pname);
+		exit(1);
+	}
+	tsc_ns=calibrate();
+	overhead=~0ull;
+	for (x=0; x<NARGS; x++)
+		if ((c=time1(nop,(s16)x)) < overhead)
+			overhead=c;
+	for (x=0; x<NARGS; x++) {
+		xa[x]=(s16)x;
+		xb[x]=(s16)(x*40503u);		/* every value, scattered */
+		xiq[2*x]=xa[x];
+		xiq[2*x+1]=xb[x];
+	}
+
+	printf("{\n  \"resolution\": \"%s\",\n  \"unit\": %d,\n"
+		   "  \"tsc_per_ns\": %.4f,\n",
+		   UI==128?"binary":"decimal",UI,tsc_ns);
+	printf("  \"unary\": [\n");
+	for (i=0, sep=""; i<(int)(sizeof unary/sizeof unary[0]); i++)
+		if (!filter || strstr(unary[i].name,filter)) {
+			printf("%s",sep);
+			bench_unary(i,reps);
+			sep=",\n";
+		}
+	printf("\n  ],\n  \"binary\": [\n");
+	for (i=0, sep=""; i<(int)(sizeof binary/sizeof binary[0]); i++)
+		if (!filter || strstr(binary[i].name,filter)) {
+			printf("%s",sep);
+			bench_binary(i,reps,step);
+			sep=",\n";
+		}
+	printf("\n  ],\n  \"batch\": [\n");
+	sep="";
+	BATCH("s16_mul_n",s16_mul_n(xa,xb,xr,NARGS))
+	BATCH("s16_div_n",s16_div_n(xa,xb,xr,NARGS))
+	BATCH("s16_sqrt_n",s16_sqrt_n(xa,xr,NARGS))
+	BATCH("s16_rsqrt_n",s16_rsqrt_n(xa,xr,NARGS))
+	BATCH("s16_hypot_n",s16_hypot_n(xiq,xr,NARGS))
+	BATCH("s16_polar_n",s16_polar_n(xiq,xr,xs,NARGS))
+	BATCH("s16_rotate_n",s16_rotate_n(xiq,RI/2,xriq,NARGS))
+	BATCH("s16_rotate_np",s16_rotate_np(xiq,xa,xriq,NARGS))
+	BATCH("s16_sincos_n",s16_sincos_n(xa,xr,xs,NARGS))
+	BATCH("s16_trig_n",
+		  s16_trig_n(xa,xr,xs,xriq,xriq+NARGS,NARGS))
+	BATCH("s16_nco_n",(s16_nco_init(&nco,0,7,0),s16_nco_n(&nco,xr,xs,NARGS)))
+	/* prepared operators, each against the scalar calls they replace */
+	BATCH("s16_divider_n",
+		  (s16_divider_init(&dv,3*UI),s16_divider_n(&dv,xa,xr,NARGS)))
+	BATCH("s16_div_by_3",
+		  for (x=0; x<NARGS; x++) xr[x]=s16_div(xa[x],3*UI))
+	BATCH("s16_powexp_n",
+		  (s16_powexp_init(&pe,3*UI/2),s16_powexp_n(&pe,xa,xr,NARGS)))
+	BATCH("s16_powexp_to_1.5",
+		  for (x=0; x<NARGS; x++) xr[x]=s16_powexp(xa[x],3*UI/2))
+	BATCH("s16_powexp_n_root",
+		  (s16_powexp_init_root(&pe,3*UI),s16_powexp_n(&pe,xa,xr,NARGS)))
+	BATCH("s16_root_3",
+		  for (x=0; x<NARGS; x++) xr[x]=s16_root(xa[x],3*UI))
+	BATCH("s16_logbase_n",
+		  (s16_logbase_init(&lb,10*UI),s16_logbase_n(&lb,xa,xr,NARGS)))
+	BATCH("s16_log_10",
+		  for (x=0; x<NARGS; x++) xr[x]=s16_log(10*UI,xa[x]))
+	/* whole exponents: square and multiply against the s16_mul() chain */
+	BATCH("s16_powi_7",
+		  for (x=0; x<NARGS; x++) xr[x]=s16_powi(xa[x],7))
+	BATCH("s16_pow_7",
+		  for (x=0; x<NARGS; x++) xr[x]=s16_pow(xa[x],7*UI))
+	BATCH("s16_mul_chain_7",
+		  for (x=0; x<NARGS; x++) xr[x]=mul_chain(xa[x],7))
+	BATCH("s16_powi_31",
+		  for (x=0; x<NARGS; x++) xr[x]=s16_powi(xa[x],31))
+	BATCH("s16_mul_chain_31",
+		  for (x=0; x<NARGS; x++) xr[x]=mul_chain(xa[x],31))
+	/* a gamma curve: 256 levels, the same 256 (a,n) pairs over and over */
+	BATCH("s16_pow_gamma",
+		  for (x=0; x<NARGS; x++) xr[x]=s16_pow((s16)(x&0xff),GAMMA))
+	BATCH("s16_pow_memo_gamma",
+		  for (x=0; x<NARGS; x++) xr[x]=s16_pow_memo((s16)(x&0xff),GAMMA))
+	/* the same 256 levels 7 apart, bases a stride apart in the hash */
+	BATCH("s16_pow_memo_gamma_7",
+		  for (x=0; x<NARGS; x++)
+			  xr[x]=s16_pow_memo((s16)((x&0xff)*7),GAMMA))
+	BATCH("s16_root_memo_cube",
+		  for (x=0; x<NARGS; x++) xr[x]=s16_root_memo((s16)(x&0xff),3*UI))
+	s16_memo_stats(&hits,&misses);
+	printf("\n  ],\n  \"memo\": {\"bits\": %d, \"hits\": %u, "
+		   "\"misses\": %u},\n  \"root_index\": [\n",
+		   MEMO_BITS,hits,misses);
+	if (!filter || strstr("s16_root",filter))
+		for (i=0, sep=""; i<(int)(sizeof root_index/sizeof root_index[0]);
+			 i++) {
+			printf("%s",sep);
+			bench_root(root_index[i],reps);
+			sep=",\n";
+		}
+	printf("\n  ],\n  \"precision\": [\n");
+	for (i=0, sep=""; i<(int)(sizeof prec/sizeof prec[0]); i++)
+		if (!filter || strstr(prec[i].name,filter)) {
+			bench_prec(i,reps,step,sep);
+			sep=",\n";
+		}
+	printf("\n  ]\n}\n");
+	return 0;
+
+} /* End main () */
@@ -0,0 +1,199 @@
+/* vi:set ts=4: <-- vi tabstop
+   bench.h - function tables and timing shared by bench and wcet.
+   Copyright (c) 2014 Bryan Batten <bjbatten@acm.org>
+
+   Include after the system headers: it includes s16math.h, which defines
+   abs().
+ */
+#ifndef BENCH_H
+#define BENCH_H
+#include <x86intrin.h>	/* for __rdtsc () */
+#include <time.h>		/* for clock_gettime () */
+#include "s16math.h"	/* for 16 bit fixed point math library functions */
+
+#define NARGS		65536u		/* every 16 bit argument */
+#define NCALLS		4			/* calls per timed argument */
+#define NTRIES		3			/* fastest of this many timings */
+
+typedef unsigned long long u64;
+typedef s32 (*unary_fn)(s16);
+typedef s32 (*binary_fn)(s16,s16);
+
+/* Wrappers give every function one signature for the tables below. */
+#define UNARY_FUNCS		\
+	U(s16_sin)			\
+	U(s16_cos)			\
+	U(s16_tan)			\
+	U(s16_cot)			\
+	U(s16_sec)			\
+	U(s16_csc)			\
+	U(s16_sincos)		\
+	U(s16_asin)			\
+	U(s16_acos)			\
+	U(s16_atan)			\
+	U(s16_atan_cordic)	\
+	U(s16_ln)			\
+	U(s16_log10)		\
+	U(s16_log2)			\
+	U(s16_exp)			\
+	U(s16_exp2)			\
+	U(s16_sqrt)			\
+	U(s16_rsqrt)		\
+	U(s16_round)		\
+	U(s16_todeg)		\
+	U(s16_torad)		\
+	U(s16_quadrant)		\
+	U(s16_fact)			\
+	U(s16_den)			\
+	U(s16_reduce)		\
+	U(s16_sin_lut)		\
+	U(s16_cos_lut)		\
+	U(s16_tan_lut)		\
+	U(s16_sincos_lut)	\
+	U(s16_asin_lut)		\
+	U(s16_acos_lut)		\
+	U(s16_atan_lut)		\
+	U(s16_ln_lut)		\
+	U(s16_log10_lut)	\
+	U(s16_sqrt_lut)		\
+	U(s16_round_lut)	\
+	U(s16_todeg_lut)	\
+	U(s16_torad_lut)
+
+#define BINARY_FUNCS	\
+	B(s16_mul)			\
+	B(s16_div)			\
+	B(s16_pow)			\
+	B(s16_root)			\
+	B(s16_powexp)		\
+	B(s16_log)			\
+	B(s16_atan2)		\
+	B(s16_hypot)		\
+	B(s16_polar)		\
+	B(s16_rotate)		\
+	B(s16_gcd)
+
+#define U(f)	static s32 call_##f(s16 x) { return f(x); }
+UNARY_FUNCS
+#undef U
+/* e^x the way s16_exp() replaces */
+static s32 call_exp_via_pow(s16 x)
+{
+	return s16_pow(S16_E,x);
+}
+/* 1/sqrt(x) the way s16_rsqrt() replaces */
+static s32 call_rsqrt_via_div(s16 x)
+{
+	return s16_div(UI,s16_sqrt(x));
+}
+/* (a, -a) rotated through b */
+#define s16_rotate(a,b)	s16_rotate(a,-(a),b)
+/* acos(x) by way of a square root, as the s16_acos() chain it replaces */
+static s32 call_acos_via_sqrt(s16 x)
+{
+	if (abs(x) > UI)
+		return 0;
+	return S16_PI/2-s16_atan2(x,s16_sqrt(UI-s16_mul(x,x)));
+}
+#define B(f)	static s32 call_##f(s16 a, s16 b) { return f(a,b); }
+BINARY_FUNCS
+#undef B
+#undef s16_rotate
+/* angle and magnitude the way s16_polar() replaces */
+static s32 call_atan2_and_hypot(s16 x, s16 y)
+{
+	return s16_atan2(y,x)+s16_hypot(x,y);
+}
+/* (a, -a) rotated through b the way s16_rotate() replaces */
+static s32 call_sincos_and_mul(s16 a, s16 b)
+{
+	sincos_t r;
+
+	r.sincos=s16_sincos(b);
+	return (s16_mul(a,r.s.cos)+s16_mul(a,r.s.sin))
+		+(s16_mul(a,r.s.sin)-s16_mul(a,r.s.cos));
+}
+
+static const struct {
+	const char	*name;
+	unary_fn	fn;
+} unary[]={
+#define U(f)	{ #f, call_##f },
+UNARY_FUNCS
+#undef U
+	{ "s16_exp_via_pow", call_exp_via_pow },
+	{ "s16_rsqrt_via_div", call_rsqrt_via_div },
+	{ "s16_acos_via_sqrt", call_acos_via_sqrt },
+};
+
+static const struct {
+	const char	*name;
+	binary_fn	fn;
+} binary[]={
+#define B(f)	{ #f, call_##f },
+BINARY_FUNCS
+#undef B
+	{ "s16_atan2_and_hypot", call_atan2_and_hypot },
+	{ "s16_sincos_and_mul", call_sincos_and_mul },
+};
+
+static volatile s32 sink;		/* keeps results live */
+
+static u64 now_ns(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (u64)t.tv_sec*1000000000u+t.tv_nsec;
+
+} /* End now_ns () */
+
+/* time stamp counter ticks per ns, over 100 ms */
+static double calibrate(void)
+{
+	u64 t0=now_ns(),c0=__rdtsc(),t1;
+
+	while ((t1=now_ns())-t0 < 100000000u)
+		;
+	return (double)(__rdtsc()-c0)/(t1-t0);
+
+} /* End calibrate () */
+
+static s32 nop(s16 x) { return x; }
+
+/* fastest of NTRIES timings of NCALLS calls of fn(x), in ticks */
+static u64 time1(unary_fn fn, s16 x)
+{
+	u64 best=~0ull,c;
+	int t,k;
+
+	for (t=0; t<NTRIES; t++) {
+		c=__rdtsc();
+		for (k=0; k<NCALLS; k++)
+			sink=fn(x);
+		c=__rdtsc()-c;
+		if (c < best)
+			best=c;
+	}
+	return best;
+
+} /* End time1 () */
+
+static u64 time2(binary_fn fn, s16 a, s16 b)
+{
+	u64 best=~0ull,c;
+	int t,k;
+
+	for (t=0; t<NTRIES; t++) {
+		c=__rdtsc();
+		for (k=0; k<NCALLS; k++)
+			sink=fn(a,b);
+		c=__rdtsc()-c;
+		if (c < best)
+			best=c;
+	}
+	return best;
+
+} /* End time2 () */
+
+#endif /* BENCH_H */
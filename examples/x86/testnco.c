@@ -0,0 +1,113 @@
+/* vi:set ts=4: <-- vi tabstop
+   testnco.c - run the oscillator and measure its drift from s16_sincos().
+   Copyright (c) 2014 Bryan Batten <bjbatten@acm.org>
+ */
+#include <stdio.h>		/* for printf */
+#include <stdlib.h>		/* for atoi () */
+#include <getopt.h>		/* for getopt () */
+#include <string.h>		/* for GNU strrchr () */
+#include "s16math.h"	/* for 16 bit fixed point math library functions */
+
+/* set program name */
+#define	setpn(p)							\
+		if (!((p) = strrchr(argv[0], '/')))	\
+			(p) = argv[0];					\
+		else (p)++
+
+static char *pname;
+
+static void usage ()
+{
+	fprintf(stderr, "Usage:\t\"%s[ -a anchor][ -n count][ --][ start step]"
+		" where:\n"
+		"\t-a samples between re-anchors, 0 for the default.\n"
+		"\t-n number of samples to generate, default 65536.\n"
+		"\t-- stops option scan. Allows following negative numbers.\n"
+		"\tSpecify start and step as 16 bit decimal integer radians.\n"
+		"\tWithout them, runs a set of cases that includes negative steps\n"
+		"\tand steps past pi.\n"
+		"\tPrints the largest difference, in least significant digits,\n"
+		"\tbetween each oscillator sample and s16_sincos() of its phase.\n"
+		, pname);
+}
+
+/* start and step cases run when none is given: a small step each way,
+   steps near pi each way, and steps past pi, which alias to the shorter
+   step of the other sign */
+static const qm_rad cases[][2]={
+	{ 0, 100 }, { 0, -100 }, { 1000, 3000 }, { 1000, -3000 },
+	{ 0, 5000 }, { 0, -5000 }, { 0, 32000 }, { 0, -32000 }
+};
+
+/* run one oscillator and print its largest difference from s16_sincos() */
+static void run(qm_rad start, qm_rad step, u16 anchor, long count)
+{
+	long i,worst=0;
+	int dc=0,ds=0,d;
+	qm_rad phi;
+	s16_nco_t nco;
+	sincos_t r,q;
+
+	s16_nco_init(&nco,start,step,anchor);
+	phi=nco.phi;
+	for (i=0; i<count; i++) {
+		r.sincos=s16_nco_next(&nco);
+		q.sincos=s16_sincos(phi);
+		d=abs(r.s.cos-q.s.cos);
+		if (d > dc) {
+			dc=d;
+			worst=i;
+		}
+		d=abs(r.s.sin-q.s.sin);
+		if (d > ds) {
+			ds=d;
+			worst=i;
+		}
+		phi=nco.phi;
+	}
+	printf("start=%d step=%d anchor=%u samples=%ld cos drift=%d sin drift=%d "
+		   "worst sample=%ld\n",start,step,nco.anchor,count,dc,ds,worst);
+
+} /* End run () */
+
+int main(int argc, char *argv[]) {
+	int	chr;
+	long count=65536;
+	u16 anchor=0;
+	size_t i;
+
+	setpn(pname);
+
+	/* Get program options. */
+	while ((chr = getopt( argc, argv, "a:n:h?")) != EOF ) {
+		switch (chr) {
+		case 'a':
+			anchor=atoi(optarg);
+			break;
+		case 'n':
+			count=atol(optarg);
+			break;
+		case 'h':
+		case '?':
+			usage ();
+			exit (0);
+		default :
+			fprintf( stderr, "%s: Unknown option: '%c'\n", pname, chr );
+			usage ();
+			exit (1);
+		}
+	} /* End option scan */
+
+	if (argc - optind == 0) {
+		for (i=0; i<sizeof(cases)/sizeof(cases[0]); i++)
+			run(cases[i][0],cases[i][1],anchor,count);
+		return 0;
+	}
+	if (argc - optind < 2) {
+		fprintf(stderr, "need integer values start and step\n");
+		return -1;
+	}
+	run(atoi(argv[optind]),atoi(argv[optind+1]),anchor,count);
+	return 0;
+
+} /* End main () */
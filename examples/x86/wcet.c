@@ -0,0 +1,332 @@
+/* vi:set ts=4: <-- vi tabstop
+   wcet.c - find the slowest arguments of s16math functions.
+   Copyright (c) 2014 Bryan Batten <bjbatten@acm.org>
+
+   Runs each function over its domain, measuring every call either with
+   the time stamp counter or, with -i, by counting the instructions it
+   executes, single stepped in a child process under ptrace. Prints one
+   JSON object on stdout with a histogram of the cost per call and the
+   costliest arguments. Each of those is also single stepped, or timed
+   when counting instructions, so both figures are given for them.
+
+   Instruction counts do not depend on the load of the machine or its
+   clock rate, so they repeat from run to run and can be carried to other
+   processors of the same instruction set.
+ */
+#include <sys/ptrace.h>	/* for ptrace () */
+#include <sys/user.h>	/* for struct user_regs_struct */
+#include <sys/wait.h>	/* for waitpid () */
+#include <signal.h>		/* for raise () */
+#include <stddef.h>		/* for offsetof () */
+#include <unistd.h>		/* for fork () */
+#include <stdio.h>		/* for printf */
+#include <stdlib.h>		/* for atoi () */
+#include <getopt.h>		/* for getopt () */
+#include <string.h>		/* for GNU strrchr () */
+#include "bench.h"		/* for function tables, timing */
+
+/* set program name */
+#define	setpn(p)							\
+		if (!((p) = strrchr(argv[0], '/')))	\
+			(p) = argv[0];					\
+		else (p)++
+
+#define MAXTOP		64			/* most arguments listed */
+#define MAXBINS		256			/* most histogram bins */
+
+#ifdef __x86_64__
+#define REG_PC		rip
+#define REG_SP		rsp
+#else
+#define REG_PC		eip
+#define REG_SP		esp
+#endif
+
+typedef struct {
+	s16	a,b;					/* arguments, b unused for unary */
+	u64	cost;
+} hit_t;
+
+static char *pname;
+static double tsc_ns;			/* time stamp counter ticks per ns */
+static u64 overhead;			/* ticks to time NCALLS empty calls */
+static int insns=0;				/* 1 to count instructions */
+static int ntop=5,nbins=16;
+static u64 limit=1000000;		/* most instructions stepped per call */
+static pid_t child;				/* stepped process */
+static struct user_regs_struct regs0;
+static u64 base;				/* instructions of an empty call */
+static u64 cost[NARGS];
+static hit_t top[MAXTOP];
+
+static void usage ()
+{
+	fprintf(stderr, "Usage:\t\"%s[ -i][ -s step][ -g step][ -k count]"
+		"[ -b bins][ -l limit][ -f name] where:\n"
+		"\t-i counts instructions rather than timing each call.\n"
+		"\t-s step between unary function arguments (1, 64 with -i).\n"
+		"\t-g grid step for binary function arguments, at least 256\n"
+		"\t   (257, 4099 with -i).\n"
+		"\t-k number of costliest arguments listed (5).\n"
+		"\t-b number of histogram bins (16).\n"
+		"\t-l most instructions counted per call (1000000).\n"
+		"\t-f explores only functions whose name contains name.\n"
+		, pname);
+}
+
+/* never executed: calls return here, where the child is stopped */
+static void landing(void)
+{
+	abort ();
+}
+
+/* fork a child stopped before its first instruction of interest */
+static void start_child(void)
+{
+	int st;
+
+	if (!(child=fork())) {
+		ptrace(PTRACE_TRACEME,0,NULL,NULL);
+		raise(SIGSTOP);
+		_exit(0);
+	}
+	if (child < 0 || waitpid(child,&st,0) < 0 || !WIFSTOPPED(st)
+		|| ptrace(PTRACE_GETREGS,child,NULL,&regs0) < 0) {
+		perror(pname);
+		exit(1);
+	}
+
+} /* End start_child () */
+
+/* instructions executed by fn(a,b) in the child, at most limit */
+static u64 step(unsigned long fn, s16 a, s16 b)
+{
+	struct user_regs_struct r=regs0;
+	unsigned long sp=(r.REG_SP-256)&~15ul;	/* clear of the red zone */
+	u64 n=0;
+	int st;
+
+#ifdef __x86_64__
+	r.rdi=a;
+	r.rsi=b;
+	r.orig_rax=-1;				/* no system call to restart */
+	sp-=sizeof(long);
+#else
+	ptrace(PTRACE_POKEDATA,child,(void *)sp,(void *)(long)a);
+	ptrace(PTRACE_POKEDATA,child,(void *)(sp+4),(void *)(long)b);
+	r.orig_eax=-1;
+	sp-=sizeof(long);
+#endif
+	/* call fn with the return address landing(), aligned as by a call */
+	ptrace(PTRACE_POKEDATA,child,(void *)sp,(void *)(unsigned long)landing);
+	r.REG_SP=sp;
+	r.REG_PC=fn;
+	ptrace(PTRACE_SETREGS,child,NULL,&r);
+	while (n < limit) {
+		if (ptrace(PTRACE_SINGLESTEP,child,NULL,NULL) < 0
+			|| waitpid(child,&st,0) < 0 || !WIFSTOPPED(st)
+			|| WSTOPSIG(st) != SIGTRAP) {
+			fprintf(stderr, "%s: stepped call failed at %d,%d\n",
+					pname, a, b);
+			exit(1);
+		}
+		n++;
+		if (ptrace(PTRACE_PEEKUSER,child,
+				   (void *)offsetof(struct user_regs_struct,REG_PC),NULL)
+			== (long)(unsigned long)landing)
+			break;
+	}
+	return n > base?n-base:0;
+
+} /* End step () */
+
+/* ns per call of NCALLS calls taking c ticks */
+static double callns(u64 c)
+{
+	c=c > overhead?c-overhead:0;
+	return c/tsc_ns/NCALLS;
+
+} /* End callns () */
+
+/* instructions of one call of function i */
+static u64 stepped(int bin, int i, s16 a, s16 b)
+{
+	return bin?step((unsigned long)binary[i].fn,a,b)
+			  :step((unsigned long)unary[i].fn,a,0);
+
+} /* End stepped () */
+
+/* ticks for NCALLS calls of function i */
+static u64 timed(int bin, int i, s16 a, s16 b)
+{
+	return bin?time2(binary[i].fn,a,b):time1(unary[i].fn,a);
+
+} /* End timed () */
+
+/* add an argument to the costliest ones, kept in decreasing order */
+static void rank(s16 a, s16 b, u64 c)
+{
+	int j;
+
+	if (c <= top[ntop-1].cost)
+		return;
+	for (j=ntop-1; j > 0 && c > top[j-1].cost; j--)
+		top[j]=top[j-1];
+	top[j].a=a;
+	top[j].b=b;
+	top[j].cost=c;
+
+} /* End rank () */
+
+/* print cost c in the unit of the sweep */
+static void pcost(u64 c)
+{
+	if (insns)
+		printf("%llu", c);
+	else printf("%.2f", callns(c));
+
+} /* End pcost () */
+
+static void explore(int bin, int i, int step1, int grid)
+{
+	u64 lo=~0ull,hi=0,sum=0,width,count[MAXBINS];
+	s32 a,b;
+	u32 n=0,j;
+
+	memset(top,0,sizeof top);
+	for (a=-32768; a < 32768; a+=bin?grid:step1)
+		for (b=bin?-32768:0; b < 32768; b+=bin?grid:32768) {
+			cost[n]=insns?stepped(bin,i,a,b):timed(bin,i,a,b);
+			if (cost[n] < lo)
+				lo=cost[n];
+			if (cost[n] > hi)
+				hi=cost[n];
+			sum+=cost[n];
+			rank(a,b,cost[n++]);
+		}
+	width=(hi-lo)/nbins+1;
+	memset(count,0,sizeof count);
+	for (j=0; j < n; j++)
+		count[(cost[j]-lo)/width]++;
+
+	printf("    {\"name\": \"%s\", \"calls\": %u, \"min\": ",
+		   bin?binary[i].name:unary[i].name, n);
+	pcost(lo);
+	printf(", \"mean\": ");
+	if (insns)
+		printf("%.1f", (double)sum/n);
+	else printf("%.2f", callns(sum/n));
+	printf(", \"max\": ");
+	pcost(hi);
+	printf(",\n      \"histogram\": {\"from\": ");
+	pcost(lo);
+	printf(", \"width\": ");
+	if (insns)
+		printf("%llu", width);
+	else printf("%.2f", width/tsc_ns/NCALLS);
+	printf(", \"counts\": [");
+	for (j=0; j < (u32)nbins; j++)
+		printf("%s%u", j?", ":"", (unsigned)count[j]);
+	printf("]},\n      \"argmax\": [");
+	for (j=0; j < (u32)ntop && j < n; j++) {
+		hit_t *h=&top[j];
+		u64 t=insns?timed(bin,i,h->a,h->b):h->cost;
+		u64 c=insns?h->cost:stepped(bin,i,h->a,h->b);
+
+		if (bin)
+			printf("%s{\"input\": [%d, %d], ", j?", ":"", h->a, h->b);
+		else printf("%s{\"input\": %d, ", j?", ":"", h->a);
+		printf("\"ns\": %.2f, \"insns\": %llu%s}", callns(t), c,
+			   c+base >= limit?", \"capped\": true":"");
+	}
+	printf("]}");
+
+} /* End explore () */
+
+int main(int argc, char *argv[]) {
+	int	chr,step1=0,grid=0,i;
+	const char *filter=NULL,*sep;
+	u32 x;
+	u64 c;
+
+	setpn(pname);
+
+	/* Get program options. */
+	while ((chr = getopt( argc, argv, "is:g:k:b:l:f:h?")) != EOF ) {
+		switch (chr) {
+		case 'i':
+			insns=1;
+			break;
+		case 's':
+			step1=atoi(optarg);
+			break;
+		case 'g':
+			grid=atoi(optarg);
+			break;
+		case 'k':
+			ntop=atoi(optarg);
+			break;
+		case 'b':
+			nbins=atoi(optarg);
+			break;
+		case 'l':
+			limit=strtoull(optarg,NULL,0);
+			break;
+		case 'f':
+			filter=optarg;
+			break;
+		case 'h':
+		case '?':
+			usage ();
+			exit (0);
+		default :
+			fprintf( stderr, "%s: Unknown option: '%c'\n", pname, chr );
+			usage ();
+			exit (1);
+		}
+	} /* End option scan */
+	if (!step1)
+		step1=insns?64:1;
+	if (!grid)
+		grid=insns?4099:257;
+	if (step1 < 1 || grid < 256 || ntop < 1 || ntop > MAXTOP
+		|| nbins < 1 || nbins > MAXBINS || limit < 1) {
+		usage ();
+		exit (1);
+	}
+
+	tsc_ns=calibrate();
+	overhead=~0ull;
+	for (x=0; x<NARGS; x++)
+		if ((c=time1(nop,(s16)x)) < overhead)
+			overhead=c;
+	/* fill the lazily filled tables before the child copies them */
+	for (i=0; i<(int)(sizeof unary/sizeof unary[0]); i++)
+		if (!filter || strstr(unary[i].name,filter))
+			sink=unary[i].fn(0);
+	start_child();
+	base=0;
+	base=step((unsigned long)nop,0,0);
+
+	printf("{\n  \"resolution\": \"%s\",\n  \"unit\": %d,\n"
+		   "  \"metric\": \"%s\",\n  \"tsc_per_ns\": %.4f,\n"
+		   "  \"functions\": [\n",
+		   UI==128?"binary":"decimal",UI,insns?"insns":"ns",tsc_ns);
+	sep="";
+	for (i=0; i<(int)(sizeof unary/sizeof unary[0]); i++)
+		if (!filter || strstr(unary[i].name,filter)) {
+			printf("%s",sep);
+			explore(0,i,step1,grid);
+			sep=",\n";
+		}
+	for (i=0; i<(int)(sizeof binary/sizeof binary[0]); i++)
+		if (!filter || strstr(binary[i].name,filter)) {
+			printf("%s",sep);
+			explore(1,i,step1,grid);
+			sep=",\n";
+		}
+	printf("\n  ]\n}\n");
+	kill(child,SIGKILL);
+	return 0;
+
+} /* End main () */
@@ -56,6 +56,7 @@
 #ifndef S16MATH_H
 #define S16MATH_H
 #include <stdint.h>	/* for int8_t and friends */
+#include <stddef.h>	/* for size_t */
 
 #ifdef __cplusplus
 extern "C"
@@ -178,6 +179,7 @@ typedef uint32_t	u32;
 #endif /* (don't) USE_BINARY_POINT */
 
 #define S16_NAN		(-99*QN)
+#define S16_MAX		((qm_n)32767)	/* saturated result */
 #define QD			DSCALE
 #define QN			NSCALE
 #define QR			RSCALE
@@ -272,6 +274,40 @@ typedef union {
 	s32		sincos;
 } sincos_t;
 s32  s16_sincos(qm_rad phi);	/* cos 0:15; sin 15:31 qm_n */
+void s16_sincos_n(const qm_rad *phi, qm_n *cos, qm_n *sin, size_t n);
+typedef union {
+	struct {
+		qm_n	mag;
+		qm_rad	phi;
+	}s;
+	s32		polar;
+} polar_t;
+s32  s16_polar(qm_n x, qm_n y);	/* magnitude 0:15; angle 16:31 qm_rad */
+void s16_polar_n(const qm_n *iq, qm_n *mag, qm_rad *phi, size_t n);
+typedef union {
+	struct {
+		qm_n	x;
+		qm_n	y;
+	}s;
+	s32		xy;
+} rect_t;
+s32  s16_rotate(qm_n x, qm_n y, qm_rad phi);	/* x 0:15; y 16:31 */
+void s16_rotate_n(const qm_n *iq, qm_rad phi, qm_n *r, size_t n);
+void s16_rotate_np(const qm_n *iq, const qm_rad *phi, qm_n *r, size_t n);
+/* numerically controlled oscillator: cos, sin of start+k*step, k=0,1,.. */
+typedef struct {
+	s32		cos;		/* current sample, Q1.30 */
+	s32		sin;
+	s32		dcos;		/* rotation by one step, Q1.30 */
+	s32		dsin;
+	qm_rad	phi;		/* phase of current sample, 0 <= phi < S16_RAD */
+	qm_rad	step;		/* phase increment, -S16_PI < step <= S16_PI */
+	u16		n;			/* samples until next re-anchor */
+	u16		anchor;		/* re-anchor interval */
+} s16_nco_t;
+void s16_nco_init(s16_nco_t *nco, qm_rad start, qm_rad step, u16 anchor);
+s32  s16_nco_next(s16_nco_t *nco);	/* packed like s16_sincos */
+void s16_nco_n(s16_nco_t *nco, qm_n *cos, qm_n *sin, size_t n);
 qm_n s16_tan(qm_rad phi);		/* tangent given phi in radians */
 
 s8 s16_quadrant(qm_rad phi);	/* quadrant of phi */
@@ -279,29 +315,73 @@ s8 s16_quadrant(qm_rad phi);	/* quadrant of phi */
 qm_n s16_cot(qm_rad phi);		/* 1/tan */
 qm_n s16_csc(qm_rad phi);		/* 1/sin */
 qm_n s16_sec(qm_rad phi);		/* 1/cos */
+void s16_trig_n(const qm_rad *phi, qm_n *tan, qm_n *cot, qm_n *sec,
+		qm_n *csc, size_t n);	/* any of tan..csc may be null */
 
 qm_rad s16_acos(qm_n cos);		/* arc cosine in radians */
 qm_rad s16_asin(qm_n sin);		/* arc sine in radians */
 qm_rad s16_atan(qm_n tan);		/* arc tangent in radians */
 qm_rad s16_atan2(qm_n y,qm_n x);/* arc tangent in radians from y/x */
+qm_rad s16_atan_cordic(qm_n tan);/* arc tangent by CORDIC vectoring */
 qm_n s16_hypot(qm_n x,qm_n y);	/* hypoteneuse */
+void s16_hypot_n(const qm_n *iq, qm_n *r, size_t n);	/* of (x,y) pairs */
 qm_n s16_ln(qm_n n);			/* power to which e would have to be
 								   raised to equal n. */
 qm_n s16_log(qm_n a,qm_n n);	/* power to which a would have to be
 								   raised to equal n. */
+/* logarithms to one base: multiply by a prepared 1/log2(a) */
+typedef struct {
+	s32		r;			/* UI/log2(a) times 2^(sh-26), or 0 */
+	s8		sh;
+	u8		nan;		/* base <= 0 */
+} s16_logbase_t;
+void s16_logbase_init(s16_logbase_t *lb, qm_n a);
+qm_n s16_logbase_log(const s16_logbase_t *lb, qm_n n);	/* as s16_log(a,n) */
+void s16_logbase_n(const s16_logbase_t *lb, const qm_n *n, qm_n *r, size_t cnt);
 qm_n s16_log10(qm_n n);			/* power to which 10 would have to be raised
 								   to equal n. */
+qm_n s16_log2(qm_n n);			/* power to which 2 would have to be raised
+								   to equal n. */
+qm_n s16_exp(qm_n x);			/* e^x */
+qm_n s16_exp2(qm_n x);			/* 2^x */
 u16 s16_gcd(u16 u, u16 v);		/* returns greatest common divisor u,v */
 qm_n s16_den(qm_n pwr);			/* Integer denominator of Q3.2 fraction */
 qm_n s16_div(qm_n a, qm_n b);	/* Q3.2 quotient a3.2/b3.2 */
 qm_n s16_mul(qm_n a, qm_n b);	/* Q3.2 product a3.2*b3.2 */
+/* array forms: element i of the result is the same as the scalar result */
+void s16_div_n(const qm_n *a, const qm_n *b, qm_n *q, size_t n);
+void s16_mul_n(const qm_n *a, const qm_n *b, qm_n *p, size_t n);
+/* divide by one divisor many times: multiply by a prepared reciprocal */
+typedef struct {
+	u32		m;			/* 2^32/d rounded down, 0 if s16_div() divides */
+	u16		d;			/* |b| */
+	qm_n	b;			/* divisor */
+} s16_divider_t;
+void s16_divider_init(s16_divider_t *dv, qm_n b);
+qm_n s16_divider_div(const s16_divider_t *dv, qm_n a);	/* as s16_div(a,b) */
+void s16_divider_n(const s16_divider_t *dv, const qm_n *a, qm_n *q, size_t n);
 qm_n s16_pow(qm_n a,qm_n n);	/* returns a^n */
+qm_n s16_powi(qm_n a,s8 n);		/* a^n for integer n */
+qm_n s16_powexp(qm_n a,qm_n n);	/* a^n as 2^(n*log2(a)) */
+/* one exponent or root index for many bases */
+typedef struct {
+	s32		e;			/* exponent times 2^(26-sh), 2^29 <= |e| <= 2^30 */
+	s8		sh;			/* e*log2(a)/2^32, Q20, shifted left by sh */
+	u8		neg;		/* negative base: 0 gives 0, 1 even power, 2 odd */
+} s16_powexp_t;
+void s16_powexp_init(s16_powexp_t *pe, qm_n n);		/* a^n */
+void s16_powexp_init_root(s16_powexp_t *pe, qm_n n);	/* a^(1/n) */
+qm_n s16_powexp_pow(const s16_powexp_t *pe, qm_n a);
+void s16_powexp_n(const s16_powexp_t *pe, const qm_n *a, qm_n *r, size_t n);
 s16 s16_reduce(qm_n k);			/* evaluate k/100=x/y for x and y and return x
 								   in bits 8-15, y in bits 0-7. */
 qm_n s16_round(qm_n x);			/* round to nearest, ties to even */
 qm_n s16_root(qm_n a,qm_n n);	/* returns n'th root nearest to a^(1/n) */
 #define s16_sqr(a) (s16_mul(a,a))/* returns a^2 */
 qm_n s16_sqrt(qm_n a);			/* fixed point principle square root */
+qm_n s16_rsqrt(qm_n a);			/* 1/a^(1/2), rounded to nearest */
+void s16_sqrt_n(const qm_n *a, qm_n *r, size_t n);	/* as s16_sqrt() */
+void s16_rsqrt_n(const qm_n *a, qm_n *r, size_t n);	/* as s16_rsqrt() */
 qm_n s16_fact(qm_n n);			/* returns n! */
 
 /* convert rad --> deg.
@@ -342,6 +422,8 @@ qm_rad s16_torad(qm_deg deg);	/* convert from degrees to radians */
 /* overflow checks for a = b <op> c, where <op> is +, -, *, /, power, root. */
 s16 s16_addov(qm_n a, qm_n b, qm_n c);
 #define s16_logov(a)	((a)==S16_NAN)			/* ln, log, log10 overflow check */
+#define s16_expov(a)	(abs(a)==S16_MAX)		/* exp, exp2, powexp, powi
+												   overflow check */
 s16 s16_subov(qm_n a, qm_n b, qm_n c);
 s16 s16_divov(qm_n a, qm_n b, qm_n c);
 s16 s16_mulov(qm_n a, qm_n b, qm_n c);
@@ -350,6 +432,66 @@ s16 s16_rootov(qm_n a, qm_n b, qm_n c);
 #define s16_sqrov(a)	(isneg(a))			/* squaring overflow check */
 #define s16_sqrtov(a,b)	(s16_rootov(a,b,2*UI))/* square root overflow check */
 
+/* 65536 entry table versions of the unary functions, with the same
+   results. Define S16_USE_LUT before including s16math.h to use them in
+   place of the plain names. */
+qm_n s16_cos_lut(qm_rad phi);
+qm_n s16_sin_lut(qm_rad phi);
+qm_n s16_tan_lut(qm_rad phi);
+qm_rad s16_acos_lut(qm_n cos);
+qm_rad s16_asin_lut(qm_n sin);
+qm_rad s16_atan_lut(qm_n tan);
+qm_n s16_ln_lut(qm_n n);
+qm_n s16_log10_lut(qm_n n);
+qm_n s16_round_lut(qm_n x);
+qm_n s16_sqrt_lut(qm_n a);
+qm_deg s16_todeg_lut(qm_rad rad);
+qm_rad s16_torad_lut(qm_deg deg);
+s32  s16_sincos_lut(qm_rad phi);
+s16 s16_lut_map(const char *path);	/* share tables from a mklut file */
+#ifdef S16_USE_LUT
+#define s16_cos		s16_cos_lut
+#define s16_sin		s16_sin_lut
+#define s16_tan		s16_tan_lut
+#define s16_acos	s16_acos_lut
+#define s16_asin	s16_asin_lut
+#define s16_atan	s16_atan_lut
+#define s16_ln		s16_ln_lut
+#define s16_log10	s16_log10_lut
+#define s16_round	s16_round_lut
+#define s16_sqrt	s16_sqrt_lut
+#define s16_todeg	s16_todeg_lut
+#define s16_torad	s16_torad_lut
+#define s16_sincos	s16_sincos_lut
+#endif /* S16_USE_LUT */
+/* Per thread direct mapped cache of s16_pow() and s16_root() results,
+   for repeated (a, n) pairs. A thread uses it after s16_memo_init().
+   Define S16_USE_MEMO before including s16math.h to use the _memo
+   versions in place of the plain names. */
+s16  s16_memo_init(u8 bits);		/* 2^bits entries for this thread */
+void s16_memo_free(void);
+void s16_memo_stats(u32 *hits, u32 *misses);
+qm_n s16_pow_memo(qm_n a, qm_n n);
+qm_n s16_root_memo(qm_n a, qm_n n);
+#ifdef S16_USE_MEMO
+#define s16_pow		s16_pow_memo
+#define s16_root	s16_root_memo
+#endif /* S16_USE_MEMO */
+/* Reduced precision versions, for callers that need only a digit or two:
+   iter CORDIC stages, up to NUM_CORDIC_ENTRIES, or 0 to 2 terms of the
+   s16_ln() sum. The full setting gives the s16_sincos(), s16_polar()
+   angle, s16_atan_cordic() and s16_ln() results. */
+s32  s16_sincos_p(qm_rad phi, u8 iter);
+qm_rad s16_atan2_p(qm_n y, qm_n x, u8 iter);
+qm_rad s16_atan_p(qm_n tan, u8 iter);
+qm_n s16_ln_p(qm_n n, u8 terms);
+/* Define S16_ATAN_CORDIC before including s16math.h to have s16_atan()
+   calls use CORDIC vectoring rather than the series. S16_USE_LUT takes
+   precedence. */
+#if defined(S16_ATAN_CORDIC) && !defined(s16_atan)
+#define s16_atan	s16_atan_cordic
+#endif
+
 /* omit if SDCC <= 3.10 or we have a Keil compiler */
 #if !defined(SDCC) && !defined(__C51__) && !defined(__CX51__)
 #pragma pack(pop)
@@ -0,0 +1,182 @@
+/* vi:set ts=4: <-- vi tabstop
+   s16math_fixed.hpp - C++ fixed point value types.
+   Copyright (c) 2014 Bryan Batten <bjbatten@acm.org>
+   See README for more details.
+
+   Optional, C++11 or later. fixed<Shift_or_Scale,Binary> is a 16 bit
+   number whose implied denominator is 2^Shift_or_Scale when Binary is
+   true, or Shift_or_Scale when it is false. The format is part of the
+   type, so reals, radians and degrees are distinct types, and binary and
+   decimal formats can be used side by side in one program: arithmetic
+   compiles to integer code for the format at hand, with no run time test
+   of the resolution.
+
+   +, -, * and / follow s16_mul() and s16_div() step for step with the
+   type's own denominator, so on number, the library's qm_n format, they
+   give the library's results. Conversions between formats, torad(),
+   todeg() and the circle<Binary> constants are constexpr. sin() and the
+   other library functions take number, radians and degrees: the formats
+   of the resolution the library was built with.
+
+   s16math.h defines abs(), min() and max(): include standard headers
+   first.
+ */
+#ifndef S16MATH_FIXED_HPP
+#define S16MATH_FIXED_HPP
+#include "s16math.h"
+
+namespace s16math {
+
+template <int Shift_or_Scale, bool Binary>
+class fixed {
+public:
+	/* implied denominator */
+	static constexpr s32 unit=Binary?s32(1)<<Shift_or_Scale:Shift_or_Scale;
+
+	constexpr fixed() : v(0) {}
+	/* the integer i */
+	explicit constexpr fixed(int i) : v(s16(i*unit)) {}
+	/* nearest to d */
+	explicit constexpr fixed(double d)
+		: v(s16(d < 0?d*unit-0.5:d*unit+0.5)) {}
+	/* nearest to f, halves rounded away from zero */
+	template <int S, bool B>
+	explicit constexpr fixed(fixed<S,B> f)
+		: v(s16(rescale(f.raw(),fixed<S,B>::unit))) {}
+
+	static constexpr fixed from_raw(s16 r) { return fixed(r,0); }
+	constexpr s16 raw() const { return v; }
+	constexpr double to_double() const { return double(v)/unit; }
+
+	constexpr fixed operator+() const { return *this; }
+	constexpr fixed operator-() const { return from_raw(s16(-v)); }
+	friend constexpr fixed operator+(fixed a, fixed b)
+		{ return from_raw(s16(a.v+b.v)); }
+	friend constexpr fixed operator-(fixed a, fixed b)
+		{ return from_raw(s16(a.v-b.v)); }
+	/* s16_mul(): 32 bit product, round, scale down */
+	friend constexpr fixed operator*(fixed a, fixed b)
+		{ return from_raw(s16(scaled(rounded(s32(a.v)*b.v)))); }
+	/* s16_div(): 0 for a zero divisor */
+	friend constexpr fixed operator/(fixed a, fixed b)
+		{ return from_raw(s16(quot(a.v,s16(abs(b.v)),
+									isneg(a.v)!=isneg(b.v)))); }
+
+	fixed &operator+=(fixed b) { return *this=*this+b; }
+	fixed &operator-=(fixed b) { return *this=*this-b; }
+	fixed &operator*=(fixed b) { return *this=*this*b; }
+	fixed &operator/=(fixed b) { return *this=*this/b; }
+
+	friend constexpr bool operator==(fixed a, fixed b) { return a.v == b.v; }
+	friend constexpr bool operator!=(fixed a, fixed b) { return a.v != b.v; }
+	friend constexpr bool operator<(fixed a, fixed b) { return a.v < b.v; }
+	friend constexpr bool operator>(fixed a, fixed b) { return a.v > b.v; }
+	friend constexpr bool operator<=(fixed a, fixed b) { return a.v <= b.v; }
+	friend constexpr bool operator>=(fixed a, fixed b) { return a.v >= b.v; }
+
+private:
+	s16 v;
+
+	constexpr fixed(s16 r, int) : v(r) {}
+	static constexpr s32 rescale(s32 r, s32 u)
+		{ return isneg(r)?-((-r*unit+u/2)/u):(r*unit+u/2)/u; }
+	/* nround(), fixscale(): binary adds half for either sign, then the
+	   shift floors; decimal rounds the magnitude, then divides */
+	static constexpr s32 rounded(s32 p)
+		{ return Binary || !isneg(p)?p+unit/2:p-unit/2; }
+	static constexpr s32 scaled(s32 p)
+		{ return Binary?p>>(Binary?Shift_or_Scale:0):p/unit; }
+	/* prescale(a)+(d>>1), divided by d, negated if signs differ */
+	static constexpr s32 quot(s16 a, s16 d, bool neg)
+		{ return d?(neg?-1:1)*((abs(s32(a))*unit+(d>>1))/d):0; }
+};
+
+template <int Shift_or_Scale, bool Binary>
+constexpr s32 fixed<Shift_or_Scale,Binary>::unit;
+
+/* the formats the library uses */
+typedef fixed<7,true>		q8_7;	/* binary qm_n */
+typedef fixed<10,true>		q5_10;	/* binary qm_rad */
+typedef fixed<4,true>		q11_4;	/* binary qm_deg */
+typedef fixed<100,false>	dec2;	/* decimal qm_n */
+typedef fixed<1000,false>	dec3;	/* decimal qm_rad */
+typedef fixed<10,false>		dec1;	/* decimal qm_deg */
+
+/* radians and degrees of one resolution, and the library's circle
+   constants in them */
+template <bool Binary>
+struct circle {
+	typedef fixed<Binary?10:1000,Binary>	radians;
+	typedef fixed<Binary?4:10,Binary>		degrees;
+
+	/* S16_PI, S16_RAD, S16_DEG */
+	static constexpr s32 raw_pi=s32(3142)*radians::unit/1000;
+	static constexpr s32 raw_rad=2*raw_pi;
+	static constexpr s32 raw_deg=360*degrees::unit;
+
+	static constexpr radians pi() { return radians::from_raw(raw_pi); }
+	static constexpr radians rad() { return radians::from_raw(raw_rad); }
+	static constexpr degrees deg() { return degrees::from_raw(raw_deg); }
+
+	/* s16_torad(), s16_todeg() */
+	static constexpr radians torad(degrees d)
+		{ return radians::from_raw(s16(s32(d.raw())*raw_rad/raw_deg)); }
+	static constexpr degrees todeg(radians r)
+		{ return degrees::from_raw(
+			s16((s32(r.raw())*raw_deg+raw_pi)/raw_rad)); }
+};
+
+template <bool Binary> constexpr s32 circle<Binary>::raw_pi;
+template <bool Binary> constexpr s32 circle<Binary>::raw_rad;
+template <bool Binary> constexpr s32 circle<Binary>::raw_deg;
+
+constexpr q5_10 torad(q11_4 d) { return circle<true>::torad(d); }
+constexpr dec3 torad(dec1 d) { return circle<false>::torad(d); }
+constexpr q11_4 todeg(q5_10 r) { return circle<true>::todeg(r); }
+constexpr dec1 todeg(dec3 r) { return circle<false>::todeg(r); }
+
+/* the formats of the library's resolution */
+#ifdef USE_BINARY_POINT
+typedef q8_7	number;
+typedef q5_10	radians;
+typedef q11_4	degrees;
+#else
+typedef dec2	number;
+typedef dec3	radians;
+typedef dec1	degrees;
+#endif
+
+/* library functions */
+#define S16_FIXED1(f,r,t)	\
+	inline r f(t a) { return r::from_raw(s16_##f(a.raw())); }
+#define S16_FIXED2(f,r,t)	\
+	inline r f(t a, t b) { return r::from_raw(s16_##f(a.raw(),b.raw())); }
+S16_FIXED1(sin,number,radians)
+S16_FIXED1(cos,number,radians)
+S16_FIXED1(tan,number,radians)
+S16_FIXED1(cot,number,radians)
+S16_FIXED1(sec,number,radians)
+S16_FIXED1(csc,number,radians)
+S16_FIXED1(asin,radians,number)
+S16_FIXED1(acos,radians,number)
+S16_FIXED1(atan,radians,number)
+S16_FIXED2(atan2,radians,number)
+S16_FIXED2(hypot,number,number)
+S16_FIXED1(sqrt,number,number)
+S16_FIXED1(rsqrt,number,number)
+S16_FIXED1(round,number,number)
+S16_FIXED1(ln,number,number)
+S16_FIXED1(log10,number,number)
+S16_FIXED1(log2,number,number)
+S16_FIXED1(exp,number,number)
+S16_FIXED1(exp2,number,number)
+S16_FIXED2(log,number,number)
+S16_FIXED2(pow,number,number)
+S16_FIXED2(powexp,number,number)
+S16_FIXED2(root,number,number)
+#undef S16_FIXED1
+#undef S16_FIXED2
+
+} /* namespace s16math */
+
+#endif /* S16MATH_FIXED_HPP */
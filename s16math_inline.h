@@ -0,0 +1,146 @@
+/* vi:set ts=4: <-- vi tabstop
+   s16math_inline.h - inline versions of the small leaf functions.
+   Copyright (c) 2014 Bryan Batten <bjbatten@acm.org>
+   See README for more details.
+
+   Optional. Include instead of, or after, s16math.h to have calls to
+   s16_mul, s16_div, s16_round, s16_sqrt, s16_addov, s16_divov, s16_mulov
+   and s16_quadrant compiled inline rather than called in the library.
+   Each s16_<fn>_inline function follows the library function step for
+   step, so results are identical in both resolutions. In C++14 and later
+   they are constexpr, so calls with constant arguments fold to constants.
+
+   Define S16_INLINE_NO_NAMES to keep the library names for the library
+   functions and call the inline versions by their _inline names only.
+ */
+#ifndef S16MATH_INLINE_H
+#define S16MATH_INLINE_H
+#include "s16math.h"
+
+#if defined(__cplusplus) && __cplusplus >= 201402L
+#define S16_INLINE	static constexpr
+#else
+#define S16_INLINE	static inline
+#endif
+
+/* Q3.2 product a3.2*b3.2 */
+S16_INLINE qm_n s16_mul_inline(qm_n a, qm_n b)
+{
+	s32 p=(s32)a*b;
+
+	p=nround(p);
+	return (qm_n)fixscale(p);
+}
+
+/* Q3.2 quotient a3.2/b3.2, 0 if b is 0 */
+S16_INLINE qm_n s16_div_inline(qm_n a, qm_n b)
+{
+	s32 q=0;
+	s16 d=abs(b);
+
+	if (b) {
+		q=prescale(a)+(d>>1);
+		q/=d;
+		if (isneg(a) != isneg(b))
+			q=-q;
+	}
+	return (qm_n)q;
+}
+
+/* round to nearest, ties to even */
+S16_INLINE qm_n s16_round_inline(qm_n x)
+{
+	u8 neg=isneg(x);
+	s8 d=0;
+
+	if (neg)
+		x=-x;
+	d=abs(lsdigit(x));
+	x-=d;
+	if (d > FSCALE/2 || (d == FSCALE/2 && oddfloor(x)))
+		x+=FSCALE;
+	if (isneg(x))
+		x-=FSCALE;
+	return neg?-x:x;
+}
+
+/* a^(1/2) by the Babylonian method, 0 if a is negative */
+S16_INLINE qm_n s16_sqrt_inline(qm_n a)
+{
+	s32 n=0,x=0,y=1;
+
+	if (isneg(a))
+		return 0;
+	n=prescale(a);
+	x=n>>2;
+	while (x-y > 1) {
+		x=(x+y+1)>>1;
+		y=n/x;
+	}
+	return (qm_n)x;
+}
+
+/* 1 if a=b+c overflowed */
+S16_INLINE s16 s16_addov_inline(qm_n a, qm_n b, qm_n c)
+{
+	if (isneg(b) != isneg(c))
+		return 0;
+	return isneg(a)^isneg(b);
+}
+
+/* 1 if a=b/c overflowed or c is 0 */
+S16_INLINE s16 s16_divov_inline(qm_n a, qm_n b, qm_n c)
+{
+	if (!c)
+		return 1;
+	if (!b)
+		return 0;
+	if (isneg(b) != isneg(c))
+		return !isneg(a);
+	return isneg(a);
+}
+
+/* 1 if a=b*c overflowed */
+S16_INLINE s16 s16_mulov_inline(qm_n a, qm_n b, qm_n c)
+{
+	if (!c)
+		return 0;
+	return s16_divov_inline(a,b,c);
+}
+
+/* quadrant of phi: 0 through 3, negative for negative phi */
+S16_INLINE s8 s16_quadrant_inline(qm_rad phi)
+{
+	phi=s16_unwind(phi);
+	return (s8)(phi/(S16_PI/2));
+}
+
+#ifndef S16_INLINE_NO_NAMES
+/* names already mapped, to the _lut versions say, are left alone */
+#ifndef s16_mul
+#define s16_mul		s16_mul_inline
+#endif
+#ifndef s16_div
+#define s16_div		s16_div_inline
+#endif
+#ifndef s16_round
+#define s16_round	s16_round_inline
+#endif
+#ifndef s16_sqrt
+#define s16_sqrt	s16_sqrt_inline
+#endif
+#ifndef s16_addov
+#define s16_addov	s16_addov_inline
+#endif
+#ifndef s16_divov
+#define s16_divov	s16_divov_inline
+#endif
+#ifndef s16_mulov
+#define s16_mulov	s16_mulov_inline
+#endif
+#ifndef s16_quadrant
+#define s16_quadrant	s16_quadrant_inline
+#endif
+#endif /* S16_INLINE_NO_NAMES */
+
+#endif /* S16MATH_INLINE_H */
@@ -0,0 +1,124 @@
+/* vi:set ts=4: <-- vi tabstop
+   asin.c - arc sine and arc cosine by table.
+   Copyright (c) 2014 Bryan Batten <bjbatten@acm.org>
+ */
+#include "s16math.h"
+
+/* Only the UI+1 sines 0, 1/UI, .. 1 are in the domain once the sign is
+   off, so asin is read from a table of all of them, held in units of
+   2^-16 qm_rad: no call of s16_sqrt() or any other function, and no
+   division. acos is pi/2, in the same units, less that. Both round to
+   nearest once, at the end. */
+#ifdef USE_BINARY_POINT
+#define HPI_A		105414357		/* pi/2*2^10*2^16 */
+#else
+#define HPI_A		102943708		/* pi/2*10^3*2^16 */
+#endif
+#define ASIN_SHIFT	16
+
+/* asin(i/UI)*RI*2^16 rounded, 0 <= i <= UI */
+static const s32 asintab[UI+1]={
+#ifdef USE_BINARY_POINT
+	0, 524293, 1048619, 1573008, 2097493, 2622107, 3146881, 3671848, 4197039,
+	4722489, 5248228, 5774290, 6300709, 6827516, 7354746, 7882432, 8410608,
+	8939309, 9468568, 9998421, 10528902, 11060048, 11591894, 12124476,
+	12657831, 13191997, 13727011, 14262911, 14799737, 15337526, 15876320,
+	16416160, 16957085, 17499138, 18042363, 18586801, 19132498, 19679499,
+	20227849, 20777596, 21328788, 21881473, 22435701, 22991524, 23548993,
+	24108163, 24669088, 25231825, 25796431, 26362965, 26931488, 27502062,
+	28074751, 28649621, 29226740, 29806179, 30388007, 30972301, 31559135,
+	32148590, 32740747, 33335689, 33933505, 34534284, 35138119, 35745108,
+	36355350, 36968951, 37586018, 38206663, 38831004, 39459163, 40091266,
+	40727446, 41367842, 42012597, 42661862, 43315797, 43974565, 44638343,
+	45307310, 45981660, 46661595, 47347326, 48039079, 48737090, 49441610,
+	50152904, 50871255, 51596960, 52330339, 53071730, 53821495, 54580023,
+	55347727, 56125054, 56912483, 57710531, 58519758, 59340769, 60174225,
+	61020842, 61881407, 62756782, 63647915, 64555856, 65481770, 66426955,
+	67392868, 68381151, 69393662, 70432527, 71500187, 72599474, 73733699,
+	74906783, 76123416, 77389293, 78711439, 80098694, 81562444, 83117776,
+	84785424, 86595257, 88593140, 90856333, 93535572, 97020278, 105414357
+#else
+	0, 655371, 1310807, 1966375, 2622140, 3278167, 3934523, 4591275, 5248489,
+	5906232, 6564572, 7223578, 7883318, 8543861, 9205279, 9867642, 10531023,
+	11195493, 11861128, 12528002, 13196193, 13865777, 14536833, 15209443,
+	15883688, 16559653, 17237423, 17917086, 18598731, 19282450, 19968338,
+	20656491, 21347008, 22039991, 22735546, 23433780, 24134805, 24838735,
+	25545690, 26255792, 26969168, 27685949, 28406272, 29130279, 29858115,
+	30589933, 31325893, 32066160, 32810907, 33560314, 34314569, 35073870,
+	35838424, 36608447, 37384166, 38165823, 38953668, 39747968, 40549003,
+	41357072, 42172489, 42995587, 43826722, 44666271, 45514638, 46372254,
+	47239578, 48117107, 49005372, 49904947, 50816450, 51740555, 52677989,
+	53629547, 54596099, 55578596, 56578088, 57595734, 58632819, 59690778,
+	60771219, 61875953, 63007033, 64166801, 65357953, 66583612, 67847433,
+	69153739, 70507705, 71915613, 73385215, 74926264, 76551323, 78277040,
+	80126300, 82132068, 84344977, 86850326, 89814564, 93667777, 102943708
+#endif
+
+};
+
+/* asin(x) in units of 2^-16 qm_rad; beyond +-1, +-pi/2 */
+static s32 asin_a(qm_n x)
+{
+	s32 a=abs((s32)x);
+
+	a=asintab[a > UI?UI:a];
+	return isneg(x)?-a:a;
+}
+
+/* a in units of 2^-16 qm_rad rounded to nearest qm_rad */
+static qm_rad torad(s32 a)
+{
+	s32 r=(abs(a)+(1<<(ASIN_SHIFT-1)))>>ASIN_SHIFT;
+
+	return (qm_rad)(isneg(a)?-r:r);
+}
+
+/** s16_asin - arc sine
+ * DESCRIPTION
+ *  Computes arc sine from sine. Return value saturates for sine values
+ *  beyond +-1.00.
+ * PARAMETER
+ *  x  numeric argument, the sine, supplied as a 16 bit integer having an
+ *     implied decimal point with two digits of resolution, or an implied
+ *     binary point with seven bits of resolution.
+ * RETURN
+ *  The 16 bit arc sine in radians, -pi/2 <= asin <= pi/2, represented as
+ *  an integer having an implied decimal point with three digits of
+ *  resolution, or an implied binary point with 10 bits of resolution.
+ * NOTES
+ *  Replaces the s16math library version, which calls s16_sqrt() and is
+ *  up to 20 least significant bits off near +-1. Every sine in the domain
+ *  has its own table entry, so results are the arc sine rounded to
+ *  nearest, in constant time. -32768 saturates to -pi/2, where the
+ *  library version returns 0.
+ */
+qm_rad s16_asin(qm_n x)
+{
+	return torad(asin_a(x));
+
+} /* End s16_asin () */
+
+/** s16_acos - arc cosine
+ * DESCRIPTION
+ *  Computes arc cosine from cosine, as pi/2 - asin(x). Return value
+ *  saturates for cosine values beyond +-1.00.
+ * PARAMETER
+ *  x  numeric argument, the cosine, supplied as a 16 bit integer having
+ *     an implied decimal point with two digits of resolution, or an
+ *     implied binary point with seven bits of resolution.
+ * RETURN
+ *  The 16 bit arc cosine in radians, 0 <= acos <= pi, represented as an
+ *  integer having an implied decimal point with three digits of
+ *  resolution, or an implied binary point with 10 bits of resolution.
+ * NOTES
+ *  Replaces the s16math library version, which calls s16_asin(), and so
+ *  s16_sqrt(). This one subtracts the s16_asin() table entry from pi/2
+ *  before either is rounded, so results are the arc cosine rounded to
+ *  nearest: in binary, acos(-1) is S16_PI, where the library version
+ *  returns S16_PI less one.
+ */
+qm_rad s16_acos(qm_n x)
+{
+	return torad(HPI_A-asin_a(x));
+
+} /* End s16_acos () */
@@ -0,0 +1,102 @@
+/* vi:set ts=4: <-- vi tabstop
+   atan.c - arc tangent by CORDIC vectoring.
+   Copyright (c) 2014 Bryan Batten <bjbatten@acm.org>
+ */
+#include "s16math.h"
+
+/* The vector (1, tan) is carried at 32 bits, scaled up by 2^ATAN_SHIFT,
+   so the y>>i steps keep their low bits for every stage of the table.
+   |tan| < 2^15 and the CORDIC gain is under 2, so x and y stay below
+   2^31. */
+#define ATAN_SHIFT		14
+
+/* the vectoring, cut to n stages */
+static qm_rad atan_stages(qm_n tan, u8 n)
+{
+	s32 x=(s32)UI<<ATAN_SHIFT,y=(s32)tan<<ATAN_SHIFT,xn,d;
+	s16 a=0;
+	u8 neg,i;
+
+	/* d is 0 or -1 by the sign of y; (v^d)-d negates v where d is -1 */
+	for (i=0; i<n; i++) {
+		d=y>>31;
+		xn=x+(((y>>i)^d)-d);
+		y-=((x>>i)^d)-d;
+		a+=(s16_cordictab[i]^d)-d;
+		x=xn;
+	}
+	neg=isneg(a);
+	if (neg)
+		a=-a;
+	a=scaledown(s16_round(a),SCALE_CORA);
+	return neg?-a:a;
+}
+
+/** s16_atan_cordic - arc tangent by CORDIC vectoring
+ * DESCRIPTION
+ *  Computes arc tangent from tangent by rotating the vector (1, tan) onto
+ *  the x axis with the s16_cordictab angles, summing the angles rotated
+ *  through. There is no division and no series: every argument takes
+ *  NUM_CORDIC_ENTRIES add and shift stages.
+ * PARAMETER
+ *  The tangent parameter is supplied as a 16 bit integer having an implied
+ *  binary point with seven bits of resolution, or an implied decimal point
+ *  with two digits of resolution.
+ *  tan  numeric argument.
+ * RETURN
+ *  The return value is the 16 bit arc tangent in radians represented as an
+ *  integer having an implied binary point with 10 bits of resolution, or
+ *  an implied decimal point with three digits of resolution. Results are
+ *  within one least significant bit of the arc tangent rounded to nearest
+ *  over the whole range of tangents, and approach +- pi/2 for large
+ *  tangents.
+ * NOTES
+ *  Define S16_ATAN_CORDIC before including s16math.h to have s16_atan()
+ *  calls use this function. Building s16mathx with "make ATAN=cordic" has
+ *  s16mathx supply s16_atan() as this function, for programs that cannot
+ *  be recompiled, and has the s16_atan_lut() table built from it.
+ *
+ *  Outside +- 1, where s16_atan() loses accuracy, results differ from
+ *  those of s16_atan().
+ */
+qm_rad s16_atan_cordic(qm_n tan)
+{
+	return atan_stages(tan,NUM_CORDIC_ENTRIES);
+
+} /* End s16_atan_cordic () */
+
+/** s16_atan_p - arc tangent to a given precision
+ * DESCRIPTION
+ *  Computes arc tangent from tangent as s16_atan_cordic() does, but with
+ *  the vectoring cut to iter stages, for callers that need only a digit
+ *  or two.
+ * PARAMETERS
+ *  tan   numeric argument, a 16 bit integer having an implied binary point
+ *        with seven bits of resolution, or an implied decimal point with
+ *        two digits of resolution.
+ *  iter  CORDIC stages, 0 through NUM_CORDIC_ENTRIES. Larger values are
+ *        taken as NUM_CORDIC_ENTRIES.
+ * RETURN
+ *  The arc tangent in radians, as s16_atan_cordic() returns it. With
+ *  NUM_CORDIC_ENTRIES stages it is the s16_atan_cordic() result.
+ * NOTES
+ *  The angle left after iter stages is about 2^(1-iter) rad at most. There
+ *  is no series version: the s16math library s16_atan() sums a fixed
+ *  number of terms with no way to stop early, so this cuts the CORDIC
+ *  stages instead.
+ */
+qm_rad s16_atan_p(qm_n tan, u8 iter)
+{
+	return atan_stages(tan,iter > NUM_CORDIC_ENTRIES?NUM_CORDIC_ENTRIES:iter);
+
+} /* End s16_atan_p () */
+
+#ifdef S16_ATAN_CORDIC
+/* built with ATAN=cordic: replace the series version for every caller */
+#undef s16_atan
+qm_rad s16_atan(qm_n tan)
+{
+	return s16_atan_cordic(tan);
+
+} /* End s16_atan () */
+#endif
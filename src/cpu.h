@@ -0,0 +1,65 @@
+/* vi:set ts=4: <-- vi tabstop
+   cpu.h - x86 kernel selection.
+   Copyright (c) 2014 Bryan Batten <bjbatten@acm.org>
+
+   Include ahead of s16math.h, which defines abs().
+ */
+#ifndef CPU_H
+#define CPU_H
+
+/* GCC builds for x86 ELF targets compile each kernel for its own
+   instruction set and bind the public function to the best kernel for the
+   host once, when the library is loaded, using an ifunc resolver. Calls
+   then go straight to that kernel with no test per call. Other builds
+   pick the kernel at compile time from the -march flags. */
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__ELF__) \
+	&& defined(__GNUC__) && !defined(__clang__)
+#define S16_DISPATCH
+#endif
+
+#if defined(S16_DISPATCH) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#ifdef S16_DISPATCH
+#define S16_SSE2
+#define S16_AVX2
+/* code between S16_BEGIN_<isa> and S16_END is compiled for <isa> */
+#define S16_BEGIN_SSE2	_Pragma("GCC push_options") \
+						_Pragma("GCC target(\"sse2\")")
+#define S16_BEGIN_AVX2	_Pragma("GCC push_options") \
+						_Pragma("GCC target(\"avx2\")")
+#define S16_END			_Pragma("GCC pop_options")
+/* resolvers run before constructors, so set up the CPU model first */
+#define s16_has(isa)	(__builtin_cpu_init(),__builtin_cpu_supports(isa))
+/* best of f##_avx2, f##_sse2 and f##_c */
+#define S16_KERNEL(f)	(s16_has("avx2")?f##_avx2:S16_KERNEL_SSE2(f))
+/* best of f##_sse2 and f##_c */
+#define S16_KERNEL_SSE2(f)	(s16_has("sse2")?f##_sse2:f##_c)
+#define S16_IFUNC(r)	__attribute__((ifunc(#r)))
+
+#else /* compile time */
+#ifdef __SSE2__
+#define S16_SSE2
+#endif
+#ifdef __AVX2__
+#define S16_AVX2
+#endif
+#define S16_BEGIN_SSE2
+#define S16_BEGIN_AVX2
+#define S16_END
+#if defined(__AVX2__)
+#define S16_KERNEL(f)	f##_avx2
+#elif defined(__SSE2__)
+#define S16_KERNEL(f)	f##_sse2
+#else
+#define S16_KERNEL(f)	f##_c
+#endif
+#ifdef __SSE2__
+#define S16_KERNEL_SSE2(f)	f##_sse2
+#else
+#define S16_KERNEL_SSE2(f)	f##_c
+#endif
+#endif /* S16_DISPATCH */
+
+#endif /* CPU_H */
@@ -0,0 +1,111 @@
+/* vi:set ts=4: <-- vi tabstop
+   div.c - divide.
+   Copyright (c) 2014 Bryan Batten <bjbatten@acm.org>
+ */
+#include "s16math.h"
+
+/** s16_div - divide
+ * DESCRIPTION
+ *  Computes quotient of two numbers.
+ * PARAMETERS
+ *  a  the first parameter is the dividend supplied as a 16 bit
+ *     integer having an implied binary point with 7 bits of resolution, or
+ *     an implied decimal point with two digits of resolution.
+ *  b  the second parameter is the divisor supplied as a 16 bit
+ *     integer having an implied binary point with 7 bits of resolution, or
+ *     an implied decimal point with two digits of resolution.
+ * RETURN
+ *  The return value is the 16 bit quotient represented as an integer having
+ *  an implied binary point with 7 bits of resolution, or an implied
+ *  decimal point with two digits of resolution.
+ *  Range is -327.68 through 327.67 (-256.000 through 255.127).
+ *
+ *  The function returns 0 when divide by zero is attempted.
+ * NOTES
+ *  Internal 32 bit intermediate results. Replaces the s16math library
+ *  version with the same results; the SSE2 double divide is no faster
+ *  than the integer divide for one quotient, so there is a single kernel,
+ *  built with the library's -march.
+ */
+qm_n s16_div(qm_n a, qm_n b)
+{
+	s32 q=0;
+	s16 d=abs(b);
+
+	if (b) {
+		q=prescale(a)+(d>>1);
+		q/=d;
+		if (isneg(a) != isneg(b))
+			q=-q;
+	}
+	return (qm_n)q;
+
+} /* End s16_div () */
+
+/* high 32 bits of a*b, less up to 2 for the low halves' product left out */
+static u32 mulhi(u32 a, u32 b)
+{
+	u32 ah=a>>16,al=a&0xffff,bh=b>>16,bl=b&0xffff;
+
+	return ah*bh+((ah*bl)>>16)+((al*bh)>>16);
+}
+
+/** s16_divider_init - prepare a divisor
+ * DESCRIPTION
+ *  Sets up dv to divide by b, for any number of dividends, with
+ *  s16_divider_div() or s16_divider_n().
+ * PARAMETERS
+ *  dv  divider state.
+ *  b   divisor, a 16 bit integer having an implied binary point with 7
+ *      bits of resolution, or an implied decimal point with two digits of
+ *      resolution.
+ * RETURN
+ *  None.
+ * NOTES
+ *  The one divide is here: 2^32/|b|, rounded down, is kept as the
+ *  multiplier that stands in for it. A zero divisor, and -32768 whose
+ *  magnitude s16_div() leaves negative, keep no multiplier and are
+ *  divided by s16_div() itself.
+ */
+void s16_divider_init(s16_divider_t *dv, qm_n b)
+{
+	dv->b=b;
+	dv->d=(u16)abs((s32)b);
+	dv->m=(b && b != (qm_n)0x8000)?0xffffffffu/dv->d:0;
+
+} /* End s16_divider_init () */
+
+/** s16_divider_div - divide by a prepared divisor
+ * DESCRIPTION
+ *  Computes a/b for the divisor b given to s16_divider_init().
+ * PARAMETERS
+ *  dv  divider state from s16_divider_init().
+ *  a   dividend, a 16 bit integer having an implied binary point with 7
+ *      bits of resolution, or an implied decimal point with two digits of
+ *      resolution.
+ * RETURN
+ *  The quotient s16_div(a,b) returns, for every a and b: same format as
+ *  a, rounded to nearest, and 0 for a zero divisor.
+ * NOTES
+ *  The scaled dividend is at most 23 bits, and its product with the
+ *  multiplier, over 2^32, falls at most three short of the quotient: a
+ *  multiply, split in three to stay within 32 bits, and a remainder
+ *  check that adds the shortfall back replace the integer divide.
+ */
+qm_n s16_divider_div(const s16_divider_t *dv, qm_n a)
+{
+	u32 n,q;
+	s32 r;
+
+	if (!dv->m)
+		return s16_div(a,dv->b);
+	n=(u32)prescale(a)+(dv->d>>1);
+	q=mulhi(n,dv->m);
+	for (n-=q*dv->d; n >= dv->d; n-=dv->d)
+		q++;
+	r=(s32)q;
+	if (isneg(a) != isneg(dv->b))
+		r=-r;
+	return (qm_n)r;
+
+} /* End s16_divider_div () */
@@ -0,0 +1,389 @@
+/* vi:set ts=4: <-- vi tabstop
+   div_n.c - divide arrays of fixed point numbers.
+   Copyright (c) 2014 Bryan Batten <bjbatten@acm.org>
+ */
+#include "cpu.h"		/* for S16_KERNEL () */
+#include "s16math.h"
+
+/* Same arithmetic as s16_div(): scale up the dividend magnitude, add half
+   the divisor magnitude to round, divide, then restore the sign. A zero
+   divisor gives a zero quotient. */
+static qm_n div1(qm_n a, qm_n b)
+{
+	s32 q=0;
+	s16 d=abs(b);
+
+	if (b) {
+		q=prescale(a)+(d>>1);
+		q/=d;
+		if (isneg(a)!=isneg(b))
+			q=-q;
+	}
+	return (qm_n)q;
+
+} /* End div1 () */
+
+typedef void div_n_fn(const qm_n *a, const qm_n *b, qm_n *q, size_t n);
+
+/* Each kernel does the elements it can, then hands the rest down. */
+static void div_n_c(const qm_n *a, const qm_n *b, qm_n *q, size_t n)
+{
+	size_t i;
+
+	for (i=0; i<n; i++)
+		q[i]=div1(a[i],b[i]);
+}
+
+#ifdef S16_SSE2
+S16_BEGIN_SSE2
+/* Eight quotients per call. Dividends are below 2^23, so truncating the
+   double precision quotient gives the same result as the integer divide. */
+static __m128i div2(__m128i n, __m128i d)
+{
+	__m128d q=_mm_div_pd(_mm_cvtepi32_pd(n),_mm_cvtepi32_pd(d));
+	return _mm_cvttpd_epi32(q);
+}
+
+static __m128i div4(__m128i n, __m128i d)
+{
+	__m128i q0=div2(n,d);
+	__m128i q1=div2(_mm_shuffle_epi32(n,0xee),_mm_shuffle_epi32(d,0xee));
+	return _mm_unpacklo_epi64(q0,q1);
+}
+
+static __m128i div8(__m128i a, __m128i b)
+{
+	const __m128i zero=_mm_setzero_si128();
+	__m128i sa=_mm_srai_epi16(a,15);
+	__m128i sb=_mm_srai_epi16(b,15);
+	/* 16 bit |b| leaves -32768 negative, as the s16 divisor does */
+	__m128i d=_mm_sub_epi16(_mm_xor_si128(b,sb),sb);
+	__m128i bz=_mm_cmpeq_epi16(b,zero);
+	__m128i d0,d1,n0,n1,q0,q1;
+
+	/* a zero divisor becomes 1 here and its quotient is cleared below */
+	d=_mm_or_si128(d,_mm_and_si128(bz,_mm_set1_epi16(1)));
+	d0=_mm_srai_epi32(_mm_unpacklo_epi16(zero,d),16);
+	d1=_mm_srai_epi32(_mm_unpackhi_epi16(zero,d),16);
+	/* 32 bit |a| so that -32768 becomes 32768 */
+	n0=_mm_srai_epi32(_mm_unpacklo_epi16(zero,a),16);
+	n1=_mm_srai_epi32(_mm_unpackhi_epi16(zero,a),16);
+	n0=_mm_sub_epi32(_mm_xor_si128(n0,_mm_srai_epi32(n0,31)),
+					 _mm_srai_epi32(n0,31));
+	n1=_mm_sub_epi32(_mm_xor_si128(n1,_mm_srai_epi32(n1,31)),
+					 _mm_srai_epi32(n1,31));
+#ifdef USE_BINARY_POINT
+	n0=_mm_slli_epi32(n0,UF);
+	n1=_mm_slli_epi32(n1,UF);
+#else
+	n0=_mm_add_epi32(_mm_slli_epi32(n0,6),
+			_mm_add_epi32(_mm_slli_epi32(n0,5),_mm_slli_epi32(n0,2)));
+	n1=_mm_add_epi32(_mm_slli_epi32(n1,6),
+			_mm_add_epi32(_mm_slli_epi32(n1,5),_mm_slli_epi32(n1,2)));
+#endif
+	n0=_mm_add_epi32(n0,_mm_srai_epi32(d0,1));
+	n1=_mm_add_epi32(n1,_mm_srai_epi32(d1,1));
+	q0=div4(n0,d0);
+	q1=div4(n1,d1);
+	q0=_mm_srai_epi32(_mm_slli_epi32(q0,16),16);
+	q1=_mm_srai_epi32(_mm_slli_epi32(q1,16),16);
+	q0=_mm_packs_epi32(q0,q1);
+	/* negate where operand signs differ, then clear zero divisors */
+	sa=_mm_xor_si128(sa,sb);
+	q0=_mm_sub_epi16(_mm_xor_si128(q0,sa),sa);
+	return _mm_andnot_si128(bz,q0);
+}
+
+static void div_n_sse2(const qm_n *a, const qm_n *b, qm_n *q, size_t n)
+{
+	size_t i=0;
+
+	for (; i+8<=n; i+=8)
+		_mm_storeu_si128((__m128i *)(q+i),
+			div8(_mm_loadu_si128((const __m128i *)(a+i)),
+				 _mm_loadu_si128((const __m128i *)(b+i))));
+	div_n_c(a+i,b+i,q+i,n-i);
+}
+S16_END
+#endif /* S16_SSE2 */
+
+#ifdef S16_AVX2
+S16_BEGIN_AVX2
+/* Sixteen quotients per call; same steps as div8(). */
+static __m256i div16(__m256i a, __m256i b)
+{
+	const __m256i zero=_mm256_setzero_si256();
+	__m256i sab=_mm256_srai_epi16(_mm256_xor_si256(a,b),15);
+	__m256i d=_mm256_abs_epi16(b);
+	__m256i bz=_mm256_cmpeq_epi16(b,zero);
+	__m256i n0,n1,d0,d1,q0,q1;
+
+	d=_mm256_or_si256(d,_mm256_and_si256(bz,_mm256_set1_epi16(1)));
+	d0=_mm256_srai_epi32(_mm256_unpacklo_epi16(zero,d),16);
+	d1=_mm256_srai_epi32(_mm256_unpackhi_epi16(zero,d),16);
+	n0=_mm256_abs_epi32(_mm256_srai_epi32(_mm256_unpacklo_epi16(zero,a),16));
+	n1=_mm256_abs_epi32(_mm256_srai_epi32(_mm256_unpackhi_epi16(zero,a),16));
+#ifdef USE_BINARY_POINT
+	n0=_mm256_slli_epi32(n0,UF);
+	n1=_mm256_slli_epi32(n1,UF);
+#else
+	n0=_mm256_mullo_epi32(n0,_mm256_set1_epi32(UF));
+	n1=_mm256_mullo_epi32(n1,_mm256_set1_epi32(UF));
+#endif
+	n0=_mm256_add_epi32(n0,_mm256_srai_epi32(d0,1));
+	n1=_mm256_add_epi32(n1,_mm256_srai_epi32(d1,1));
+	q0=_mm256_set_m128i(
+		_mm256_cvttpd_epi32(_mm256_div_pd(
+			_mm256_cvtepi32_pd(_mm256_extracti128_si256(n0,1)),
+			_mm256_cvtepi32_pd(_mm256_extracti128_si256(d0,1)))),
+		_mm256_cvttpd_epi32(_mm256_div_pd(
+			_mm256_cvtepi32_pd(_mm256_castsi256_si128(n0)),
+			_mm256_cvtepi32_pd(_mm256_castsi256_si128(d0)))));
+	q1=_mm256_set_m128i(
+		_mm256_cvttpd_epi32(_mm256_div_pd(
+			_mm256_cvtepi32_pd(_mm256_extracti128_si256(n1,1)),
+			_mm256_cvtepi32_pd(_mm256_extracti128_si256(d1,1)))),
+		_mm256_cvttpd_epi32(_mm256_div_pd(
+			_mm256_cvtepi32_pd(_mm256_castsi256_si128(n1)),
+			_mm256_cvtepi32_pd(_mm256_castsi256_si128(d1)))));
+	q0=_mm256_srai_epi32(_mm256_slli_epi32(q0,16),16);
+	q1=_mm256_srai_epi32(_mm256_slli_epi32(q1,16),16);
+	q0=_mm256_packs_epi32(q0,q1);
+	q0=_mm256_sub_epi16(_mm256_xor_si256(q0,sab),sab);
+	return _mm256_andnot_si256(bz,q0);
+}
+
+static void div_n_avx2(const qm_n *a, const qm_n *b, qm_n *q, size_t n)
+{
+	size_t i=0;
+
+	for (; i+16<=n; i+=16)
+		_mm256_storeu_si256((__m256i *)(q+i),
+			div16(_mm256_loadu_si256((const __m256i *)(a+i)),
+				  _mm256_loadu_si256((const __m256i *)(b+i))));
+	div_n_sse2(a+i,b+i,q+i,n-i);
+}
+S16_END
+#endif /* S16_AVX2 */
+
+#ifdef S16_DISPATCH
+static div_n_fn *resolve_div_n(void)
+{
+	return S16_KERNEL(div_n);
+}
+#endif
+
+/** s16_div_n - divide arrays
+ * DESCRIPTION
+ *  Computes q[i]=a[i]/b[i] for 0 <= i < n. Each quotient is rounded exactly
+ *  as s16_div() rounds it.
+ * PARAMETERS
+ *  a  dividends supplied as 16 bit integers having an implied binary point
+ *     with 7 bits of resolution, or an implied decimal point with two
+ *     digits of resolution.
+ *  b  divisors, same format as a.
+ *  q  receives the n quotients, same format as a. q may be the same array
+ *     as a or b, but must not otherwise overlap them.
+ *  n  number of elements.
+ * RETURN
+ *  None. As with s16_div(), a zero divisor gives a zero quotient.
+ * NOTES
+ *  x86 builds pick a scalar, SSE2 or AVX2 kernel for the host when the
+ *  library is loaded; the SSE2 and AVX2 kernels work on 8 or 16 elements
+ *  per step. Overflow is not checked: use s16_divov() on the elements if
+ *  needed.
+ */
+#ifdef S16_DISPATCH
+void s16_div_n(const qm_n *a, const qm_n *b, qm_n *q, size_t n)
+	S16_IFUNC(resolve_div_n);
+#else
+void s16_div_n(const qm_n *a, const qm_n *b, qm_n *q, size_t n)
+{
+	S16_KERNEL(div_n)(a,b,q,n);
+
+} /* End s16_div_n () */
+#endif
+
+typedef void divider_n_fn(const s16_divider_t *dv, const qm_n *a, qm_n *q,
+		size_t n);
+
+static void divider_n_c(const s16_divider_t *dv, const qm_n *a, qm_n *q,
+		size_t n)
+{
+	size_t i;
+
+	for (i=0; i<n; i++)
+		q[i]=s16_divider_div(dv,a[i]);
+}
+
+#ifdef S16_SSE2
+S16_BEGIN_SSE2
+/* The high halves of four 32 by 32 bit products. */
+static __m128i mulhi4(__m128i a, __m128i m)
+{
+	__m128i e=_mm_mul_epu32(a,m);
+	__m128i o=_mm_mul_epu32(_mm_srli_epi64(a,32),m);
+
+	return _mm_or_si128(_mm_srli_epi64(e,32),
+			_mm_and_si128(o,_mm_set_epi32(-1,0,-1,0)));
+}
+
+/* Four quotients of scaled dividends n, as divider8() takes them. The
+   whole 64 bit product falls at most one short, so one remainder check
+   makes it exact. */
+static __m128i quot4(__m128i n, __m128i m, __m128i d)
+{
+	__m128i q=mulhi4(n,m);
+	__m128i e=_mm_mul_epu32(q,d);
+	__m128i o=_mm_mul_epu32(_mm_srli_epi64(q,32),d);
+	__m128i r=_mm_sub_epi32(n,_mm_or_si128(
+			_mm_and_si128(e,_mm_set_epi32(0,-1,0,-1)),_mm_slli_epi64(o,32)));
+
+	return _mm_sub_epi32(q,_mm_cmpgt_epi32(r,
+			_mm_sub_epi32(d,_mm_set1_epi32(1))));
+}
+
+/* Eight quotients per call, by the steps of div8() with the divide
+   replaced. */
+static __m128i divider8(__m128i a, __m128i m, __m128i d, __m128i sb)
+{
+	const __m128i zero=_mm_setzero_si128();
+	__m128i sa=_mm_srai_epi16(a,15);
+	__m128i h=_mm_srli_epi32(d,1);
+	__m128i n0,n1,q0,q1;
+
+	n0=_mm_srai_epi32(_mm_unpacklo_epi16(zero,a),16);
+	n1=_mm_srai_epi32(_mm_unpackhi_epi16(zero,a),16);
+	n0=_mm_sub_epi32(_mm_xor_si128(n0,_mm_srai_epi32(n0,31)),
+					 _mm_srai_epi32(n0,31));
+	n1=_mm_sub_epi32(_mm_xor_si128(n1,_mm_srai_epi32(n1,31)),
+					 _mm_srai_epi32(n1,31));
+#ifdef USE_BINARY_POINT
+	n0=_mm_slli_epi32(n0,UF);
+	n1=_mm_slli_epi32(n1,UF);
+#else
+	n0=_mm_add_epi32(_mm_slli_epi32(n0,6),
+			_mm_add_epi32(_mm_slli_epi32(n0,5),_mm_slli_epi32(n0,2)));
+	n1=_mm_add_epi32(_mm_slli_epi32(n1,6),
+			_mm_add_epi32(_mm_slli_epi32(n1,5),_mm_slli_epi32(n1,2)));
+#endif
+	q0=quot4(_mm_add_epi32(n0,h),m,d);
+	q1=quot4(_mm_add_epi32(n1,h),m,d);
+	q0=_mm_srai_epi32(_mm_slli_epi32(q0,16),16);
+	q1=_mm_srai_epi32(_mm_slli_epi32(q1,16),16);
+	q0=_mm_packs_epi32(q0,q1);
+	sa=_mm_xor_si128(sa,sb);
+	return _mm_sub_epi16(_mm_xor_si128(q0,sa),sa);
+}
+
+static void divider_n_sse2(const s16_divider_t *dv, const qm_n *a, qm_n *q,
+		size_t n)
+{
+	const __m128i m=_mm_set1_epi32((s32)dv->m);
+	const __m128i d=_mm_set1_epi32(dv->d);
+	const __m128i sb=_mm_set1_epi16(isneg(dv->b)?-1:0);
+	size_t i=0;
+
+	if (dv->m)
+		for (; i+8<=n; i+=8)
+			_mm_storeu_si128((__m128i *)(q+i),divider8(
+				_mm_loadu_si128((const __m128i *)(a+i)),m,d,sb));
+	divider_n_c(dv,a+i,q+i,n-i);
+}
+S16_END
+#endif /* S16_SSE2 */
+
+#ifdef S16_AVX2
+S16_BEGIN_AVX2
+/* Eight quotients of scaled dividends; same steps as quot4(). */
+static __m256i quot8(__m256i n, __m256i m, __m256i d)
+{
+	__m256i e=_mm256_mul_epu32(n,m);
+	__m256i o=_mm256_mul_epu32(_mm256_srli_epi64(n,32),m);
+	__m256i q=_mm256_blend_epi32(_mm256_srli_epi64(e,32),o,0xaa);
+	__m256i r=_mm256_sub_epi32(n,_mm256_mullo_epi32(q,d));
+
+	return _mm256_sub_epi32(q,_mm256_cmpgt_epi32(r,
+			_mm256_sub_epi32(d,_mm256_set1_epi32(1))));
+}
+
+/* Sixteen quotients per call; same steps as divider8(). */
+static __m256i divider16(__m256i a, __m256i m, __m256i d, __m256i sb)
+{
+	const __m256i zero=_mm256_setzero_si256();
+	__m256i sab=_mm256_xor_si256(_mm256_srai_epi16(a,15),sb);
+	__m256i h=_mm256_srli_epi32(d,1);
+	__m256i n0,n1,q0,q1;
+
+	n0=_mm256_abs_epi32(_mm256_srai_epi32(_mm256_unpacklo_epi16(zero,a),16));
+	n1=_mm256_abs_epi32(_mm256_srai_epi32(_mm256_unpackhi_epi16(zero,a),16));
+#ifdef USE_BINARY_POINT
+	n0=_mm256_slli_epi32(n0,UF);
+	n1=_mm256_slli_epi32(n1,UF);
+#else
+	n0=_mm256_mullo_epi32(n0,_mm256_set1_epi32(UF));
+	n1=_mm256_mullo_epi32(n1,_mm256_set1_epi32(UF));
+#endif
+	q0=quot8(_mm256_add_epi32(n0,h),m,d);
+	q1=quot8(_mm256_add_epi32(n1,h),m,d);
+	q0=_mm256_srai_epi32(_mm256_slli_epi32(q0,16),16);
+	q1=_mm256_srai_epi32(_mm256_slli_epi32(q1,16),16);
+	q0=_mm256_packs_epi32(q0,q1);
+	return _mm256_sub_epi16(_mm256_xor_si256(q0,sab),sab);
+}
+
+static void divider_n_avx2(const s16_divider_t *dv, const qm_n *a, qm_n *q,
+		size_t n)
+{
+	const __m256i m=_mm256_set1_epi32((s32)dv->m);
+	const __m256i d=_mm256_set1_epi32(dv->d);
+	const __m256i sb=_mm256_set1_epi16(isneg(dv->b)?-1:0);
+	size_t i=0;
+
+	if (dv->m)
+		for (; i+16<=n; i+=16)
+			_mm256_storeu_si256((__m256i *)(q+i),divider16(
+				_mm256_loadu_si256((const __m256i *)(a+i)),m,d,sb));
+	divider_n_sse2(dv,a+i,q+i,n-i);
+}
+S16_END
+#endif /* S16_AVX2 */
+
+#ifdef S16_DISPATCH
+static divider_n_fn *resolve_divider_n(void)
+{
+	return S16_KERNEL(divider_n);
+}
+#endif
+
+/** s16_divider_n - divide an array by a prepared divisor
+ * DESCRIPTION
+ *  Computes q[i]=a[i]/b for 0 <= i < n, for the divisor b given to
+ *  s16_divider_init(). Each quotient is the one s16_div() returns.
+ * PARAMETERS
+ *  dv  divider state from s16_divider_init().
+ *  a   dividends supplied as 16 bit integers having an implied binary
+ *      point with 7 bits of resolution, or an implied decimal point with
+ *      two digits of resolution.
+ *  q   receives the n quotients, same format as a. q may be the same
+ *      array as a, but must not otherwise overlap it.
+ *  n   number of elements.
+ * RETURN
+ *  None. A zero divisor gives zero quotients.
+ * NOTES
+ *  x86 builds pick a scalar, SSE2 or AVX2 kernel for the host when the
+ *  library is loaded. The SSE2 and AVX2 kernels work on 8 or 16 elements
+ *  per step with the whole 64 bit product of each dividend and the
+ *  multiplier, and no double divide. The divisor -32768 is handled by
+ *  s16_div() one element at a time.
+ */
+#ifdef S16_DISPATCH
+void s16_divider_n(const s16_divider_t *dv, const qm_n *a, qm_n *q, size_t n)
+	S16_IFUNC(resolve_divider_n);
+#else
+void s16_divider_n(const s16_divider_t *dv, const qm_n *a, qm_n *q, size_t n)
+{
+	S16_KERNEL(divider_n)(dv,a,q,n);
+
+} /* End s16_divider_n () */
+#endif
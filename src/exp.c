@@ -0,0 +1,529 @@
+/* vi:set ts=4: <-- vi tabstop
+   exp.c - evaluate exponentials.
+   Copyright (c) 2014 Bryan Batten <bjbatten@acm.org>
+ */
+#include "s16math.h"
+
+/* 2^t for t in Q20 is 2^i * 2^(j/16) * 2^r, where i is the integer part
+   of t, j the next four bits and 0 <= r < 1/16 the rest. 2^(j/16) comes
+   from a Q28 table and 2^r - 1 from its cubic Taylor polynomial in Q20,
+   so the product is good to about 2^-21 relative. */
+#define EXP_SHIFT		20
+#define EXP_BITS		4				/* log2 of table entries */
+#define EXP_TAB			28				/* table entries, product in Q28 */
+#define LN2_Q16			((s32)45426)	/* ln(2) */
+#define LOG2E_Q20		((s32)1512775)	/* 1/ln(2) */
+#define EXP_RANGE		(8*UI)			/* e^x saturates or is 0 beyond */
+#ifndef USE_BINARY_POINT
+#define EXP2_RANGE		(16*UI)			/* 2^x saturates or is 0 beyond */
+#endif
+
+/* log2(a) for s16_powexp() is carried in Q26. a = x*2^k with 1 <= x < 2,
+   and x times a Q32 reciprocal of the centre of its 1/64 interval is
+   1+r, |r| < 1/129. log2(x) is the tabulated -log2 of the reciprocal
+   plus ln(1+r)/ln(2), from its cubic Taylor polynomial in Q30, and the
+   sum is within about one unit of Q26. */
+#define LOG_SHIFT		26
+#define LOG_BITS		6				/* log2 of table entries */
+#define LOG2EM1_Q20		((s32)464199)	/* 1/ln(2)-1 */
+#define POW_RANGE		((s32)1<<24)	/* n*log2(a) saturates or is 0 */
+#ifdef USE_BINARY_POINT
+#define LOG2UI_Q26		((s32)NSHIFT<<LOG_SHIFT)	/* log2(128) */
+#else
+#define LOG2UI_Q26		((s32)445861641)/* log2(100) */
+#endif
+
+/* 2^(j/16) in Q28 */
+static const u32 exp2tab[1<<EXP_BITS]={
+	268435456, 280320109, 292730940, 305691246, 319225354, 333358668,
+	348117717, 363530205, 379625062, 396432500, 413984066, 432312707,
+	451452825, 471440350, 492312797, 514109347
+};
+
+/* 2^32/(1+(j+1/2)/64), rounded */
+static const u32 logrcp[1<<LOG_BITS]={
+	4261672976u, 4196609266u, 4133502360u, 4072265288u, 4012816160u,
+	3955077798u, 3898977403u, 3844446251u, 3791419406u, 3739835469u,
+	3689636335u, 3640766979u, 3593175254u, 3546811703u, 3501629388u,
+	3457583735u, 3414632384u, 3372735055u, 3331853418u, 3291950981u,
+	3252992982u, 3214946280u, 3177779271u, 3141461794u, 3105965050u,
+	3071261530u, 3037324939u, 3004130131u, 2971653048u, 2939870663u,
+	2908760920u, 2878302691u, 2848475720u, 2819260584u, 2790638649u,
+	2762592030u, 2735103552u, 2708156719u, 2681735678u, 2655825188u,
+	2630410593u, 2605477791u, 2581013211u, 2557003786u, 2533436930u,
+	2510300520u, 2487582868u, 2465272708u, 2443359173u, 2421831779u,
+	2400680410u, 2379895298u, 2359467012u, 2339386442u, 2319644784u,
+	2300233531u, 2281144456u, 2262369604u, 2243901281u, 2225732040u,
+	2207854674u, 2190262207u, 2172947881u, 2155905153u
+};
+
+/* -log2(logrcp[j]/2^32) in Q30 */
+static const s32 log2tab[1<<LOG_BITS]={
+	12055174, 35887675, 59359063, 82480119, 105261147, 127712004, 149842124,
+	171660541, 193175915, 214396548, 235330407, 255985140, 276368092,
+	296486322, 316346620, 335955515, 355319292, 374444004, 393335482,
+	411999347, 430441017, 448665722, 466678506, 484484242, 502087636,
+	519493235, 536705434, 553728485, 570566499, 587223455, 603703206,
+	620009483, 636145900, 652115959, 667923055, 683570481, 699061430,
+	714399001, 729586201, 744625951, 759521085, 774274358, 788888448,
+	803365955, 817709410, 831921271, 846003931, 859959719, 873790900,
+	887499681, 901088206, 914558569, 927912807, 941152905, 954280797,
+	967298370, 980207461, 993009865, 1005707329, 1018301561, 1030794226,
+	1043186948, 1055481314, 1067678873
+};
+
+/* 2^t as qm_n, S16_MAX if it does not fit */
+static qm_n exp2q20(s32 t)
+{
+	s32 i=t>>EXP_SHIFT,s;
+	u32 q,q2,e,p;
+
+	/* 2^r - 1 = e^(r*ln(2)) - 1, with q = r*ln(2) < 0.044 */
+	q=((u32)t&((1<<(EXP_SHIFT-EXP_BITS))-1))*LN2_Q16>>16;
+	q2=(q*q)>>EXP_SHIFT;
+	e=q+(q2>>1)+((q2*q)>>EXP_SHIFT)/6;
+	/* table entry times 1 + e, the Q15 by Q20 product over 2^7 */
+	p=exp2tab[(t>>(EXP_SHIFT-EXP_BITS))&((1<<EXP_BITS)-1)];
+	p+=((p>>(EXP_TAB-15))*e)>>(EXP_SHIFT+15-EXP_TAB);
+#ifdef USE_BINARY_POINT
+	s=EXP_TAB-NSHIFT-i;
+#else
+	p=(p>>6)*UI;				/* Q22, times 100 still fits */
+	s=EXP_TAB-6-i;
+#endif
+	if (s < 1)
+		return S16_MAX;
+	if (s > 31)
+		return 0;
+	p=((p>>(s-1))+1)>>1;		/* adding half first could carry out */
+	return p > S16_MAX?S16_MAX:(qm_n)p;
+
+} /* End exp2q20 () */
+
+/** s16_exp2 - evaluate power of two
+ * DESCRIPTION
+ *  Evaluates 2^x.
+ * PARAMETER
+ *  x  exponent, a 16 bit integer having an implied binary point with 7
+ *     bits of resolution, or an implied decimal point with two digits of
+ *     resolution.
+ * RETURN
+ *  The power, in the same format as x. Powers too large to represent
+ *  saturate to S16_MAX, 255.127 (327.67 decimal), which s16_expov()
+ *  detects: no other argument gives that result. Powers that round to
+ *  less than the least significant bit are 0.
+ * NOTES
+ *  Shift by the integer part of x, a 16 entry table for the next four
+ *  bits of the fraction, and a cubic polynomial for the rest, with 32
+ *  bit intermediate results. Results are within one least significant
+ *  bit of 2^x rounded to nearest.
+ */
+qm_n s16_exp2(qm_n x)
+{
+#ifdef USE_BINARY_POINT
+	return exp2q20((s32)x<<(EXP_SHIFT-NSHIFT));
+#else
+	s32 t;
+
+	/* keeps x*2^18 in 32 bits */
+	if (x > EXP2_RANGE)
+		return S16_MAX;
+	if (x < -EXP2_RANGE)
+		return 0;
+	t=(s32)x<<(EXP_SHIFT-2);		/* x*2^20/100 = x*2^18/25 */
+	return exp2q20((t+(isneg(t)?-12:12))/25);
+#endif
+
+} /* End s16_exp2 () */
+
+/** s16_exp - evaluate exponential
+ * DESCRIPTION
+ *  Evaluates e^x.
+ * PARAMETER
+ *  x  exponent, a 16 bit integer having an implied binary point with 7
+ *     bits of resolution, or an implied decimal point with two digits of
+ *     resolution.
+ * RETURN
+ *  The power, in the same format as x. Powers too large to represent
+ *  saturate to S16_MAX, which s16_expov() detects. Powers that round to
+ *  less than the least significant bit are 0.
+ * NOTES
+ *  Evaluated as 2^(x/ln(2)) by the method of s16_exp2(), in place of
+ *  s16_pow(S16_E,x), which rounds x down to a multiple of 1/4 and takes
+ *  S16_E as 2.72.
+ */
+qm_n s16_exp(qm_n x)
+{
+	s32 t;
+
+	/* keeps x*LOG2E_Q20 in 32 bits */
+	if (x > EXP_RANGE)
+		return S16_MAX;
+	if (x < -EXP_RANGE)
+		return 0;
+	t=(s32)x*LOG2E_Q20;
+#ifdef USE_BINARY_POINT
+	/* Q7 times Q20 is Q27 */
+	t=(t+((s32)1<<(NSHIFT+20-EXP_SHIFT-1)))>>(NSHIFT+20-EXP_SHIFT);
+#else
+	/* x/100*LOG2E_Q20 */
+	t=(t+(isneg(t)?-50:50))/100;
+#endif
+	return exp2q20(t);
+
+} /* End s16_exp () */
+
+/* log2(a/UI) in Q26, for 0 < a <= 32768 */
+static s32 log2q26(s32 a)
+{
+	u32 x,xh,xl,rh,rl;
+	s32 r,r2,r3,l;
+	u8 k,j;
+
+#ifdef __GNUC__
+	k=(u8)(31-__builtin_clz((unsigned)a));
+#else
+	for (k=15; !(a>>k); k--)
+		;
+#endif
+	/* x in Q30, then r = x*logrcp[j]/2^32 - 1, also Q30 */
+	x=(u32)a<<(30-k);
+	j=(u8)((x>>(30-LOG_BITS))&((1<<LOG_BITS)-1));
+	xh=x>>16;
+	xl=x&0xffff;
+	rh=logrcp[j]>>16;
+	rl=logrcp[j]&0xffff;
+	r=(s32)(xh*rh+((xh*rl)>>16)+((xl*rh)>>16)-((u32)1<<30));
+	/* r - r^2/2 + r^3/3, with r over 2^8 in the products */
+	r2=((r>>8)*(r>>8))>>14;
+	r3=(r2*(r>>8))>>22;
+	r=r-(r2>>1)+((r3*21845)>>16);
+	/* r plus r*(1/ln(2)-1), split so neither product overflows */
+	l=r+((r>>12)*LOG2EM1_Q20>>8)+(((r&0xfff)*LOG2EM1_Q20)>>20);
+	l=(l+log2tab[j]+((s32)1<<(30-LOG_SHIFT-1)))>>(30-LOG_SHIFT);
+	return l+((s32)k<<LOG_SHIFT)-LOG2UI_Q26;
+
+} /* End log2q26 () */
+
+/** s16_powexp - evaluate power by exponential and logarithm
+ * DESCRIPTION
+ *  Evaluates a^n as 2^(n*log2(a)), for any exponent n.
+ * PARAMETERS
+ *  The parameters are 16 bit integers having an implied binary point with
+ *  7 bits of resolution, or an implied decimal point with two digits of
+ *  resolution.
+ *  a  base.
+ *  n  exponent.
+ * RETURN
+ *  The power, in the same format as a. Powers too large to represent
+ *  saturate to S16_MAX, or -S16_MAX for a negative base, which
+ *  s16_expov() detects. Powers that round to less than the least
+ *  significant bit are 0.
+ *
+ *  0^n is 0 for positive n and saturates for negative n; a^0 is 1. A
+ *  negative base takes only whole exponents, the sign of the power
+ *  following their parity: a fractional one returns 0.
+ * NOTES
+ *  Unlike s16_pow(), which reduces the fraction of n to a multiple of 1/4
+ *  and evaluates a root and a power, every argument takes the same steps:
+ *  log2(a) in Q26 from a 64 entry reciprocal table and a cubic, one
+ *  product split in two to stay within 32 bits, and the 2^x of
+ *  s16_exp2(). The exponent is used at full resolution, and results are
+ *  within one least significant bit of a^n rounded to nearest.
+ */
+qm_n s16_powexp(qm_n a, qm_n n)
+{
+	s32 l,x;
+	qm_n p;
+	u8 neg=0;
+
+	if (!n)
+		return UI;
+	if (!a)
+		return isneg(n)?S16_MAX:0;
+	if (isneg(a)) {
+		if (n%UI)
+			return 0;
+		neg=(n/UI)&1;
+	}
+	l=log2q26(abs((s32)a));
+	/* x = n*l/2^14, with l split so neither product overflows */
+	x=n*(l>>14)+((n*(l&0x3fff))>>14);
+	if (x > POW_RANGE)
+		x=POW_RANGE;
+	else if (x < -POW_RANGE)
+		x=-POW_RANGE;
+#ifdef USE_BINARY_POINT
+	/* Q7 times Q26, over 2^14, is Q19 */
+	x<<=EXP_SHIFT-19;
+#else
+	/* n/100*l/2^26*2^20 = x*64/25 */
+	x=(x*64+(isneg(x)?-12:12))/25;
+#endif
+	p=exp2q20(x);
+	return neg?-p:p;
+
+} /* End s16_powexp () */
+
+/* The prepared operators below keep their invariant operand as a 30 bit
+   mantissa and a shift, so that each element takes one 32 by 32 bit
+   product in place of a divide or a second logarithm. */
+
+/* num/den*2^t rounded to nearest, t the least that makes it at least
+   2^29, for 0 < den < 2^30 and num < 2^30 */
+static u32 normdiv(u32 num, u32 den, s8 *t)
+{
+	u32 q=num/den,r=num%den;
+
+	for (*t=0; q < (u32)1<<29; (*t)++) {
+		r<<=1;
+		q<<=1;
+		if (r >= den) {
+			r-=den;
+			q|=1;
+		}
+	}
+	return q+(r >= den-r);
+
+} /* End normdiv () */
+
+/* high 32 bits of a*b, with the low 32 in *lo */
+static u32 mul32(u32 a, u32 b, u32 *lo)
+{
+	u32 ah=a>>16,al=a&0xffff,bh=b>>16,bl=b&0xffff;
+	u32 m=((al*bl)>>16)+(al*bh&0xffff)+(ah*bl&0xffff);
+
+	*lo=(m<<16)|(al*bl&0xffff);
+	return ah*bh+((al*bh)>>16)+((ah*bl)>>16)+(m>>16);
+
+} /* End mul32 () */
+
+/* exponent num/den for pe, 0 < den */
+static void powexp_set(s16_powexp_t *pe, s32 num, s32 den)
+{
+	s8 t;
+
+	pe->e=0;
+	pe->sh=0;
+	if (!num)
+		return;
+	pe->e=(s32)normdiv((u32)abs(num),(u32)den,&t);
+	if (isneg(num))
+		pe->e=-pe->e;
+	/* e/2^t times l/2^26, in Q20, is e*l/2^32 times 2^(26-t) */
+	pe->sh=(s8)(26-t);
+
+} /* End powexp_set () */
+
+/** s16_powexp_init - prepare an exponent
+ * DESCRIPTION
+ *  Sets up pe to raise any number of bases to the power n, with
+ *  s16_powexp_pow() or s16_powexp_n().
+ * PARAMETERS
+ *  pe  power state.
+ *  n   exponent, a 16 bit integer having an implied binary point with 7
+ *      bits of resolution, or an implied decimal point with two digits of
+ *      resolution.
+ * RETURN
+ *  None.
+ * NOTES
+ *  n/UI is kept as a 30 bit mantissa and a shift, so the decimal
+ *  exponent's divide by 100 is done once here.
+ */
+void s16_powexp_init(s16_powexp_t *pe, qm_n n)
+{
+	powexp_set(pe,n,UI);
+	/* a negative base takes whole exponents only, by their parity */
+	pe->neg=(u8)(n%UI?0:1+((n/UI)&1));
+
+} /* End s16_powexp_init () */
+
+/** s16_powexp_init_root - prepare a root index
+ * DESCRIPTION
+ *  Sets up pe to take the nth root of any number of radicands, that is
+ *  to raise them to the power 1/n, with s16_powexp_pow() or
+ *  s16_powexp_n().
+ * PARAMETERS
+ *  pe  power state.
+ *  n   index, a 16 bit integer having an implied binary point with 7 bits
+ *      of resolution, or an implied decimal point with two digits of
+ *      resolution.
+ * RETURN
+ *  None.
+ * NOTES
+ *  1/n is taken to 30 bits once, here. Unlike s16_root(), the index is
+ *  not reduced to a multiple of 1/4. A negative radicand takes only an
+ *  odd whole index, giving a negative root; other indices give 0, and a
+ *  zero index gives 1, as a zero exponent does.
+ */
+void s16_powexp_init_root(s16_powexp_t *pe, qm_n n)
+{
+	powexp_set(pe,n?(isneg(n)?-UI:UI):0,abs((s32)n));
+	pe->neg=(u8)(n && !(n%UI) && ((n/UI)&1)?2:0);
+
+} /* End s16_powexp_init_root () */
+
+/** s16_powexp_pow - evaluate power of prepared exponent
+ * DESCRIPTION
+ *  Evaluates a^n for the exponent given to s16_powexp_init(), or
+ *  a^(1/n) for the index given to s16_powexp_init_root().
+ * PARAMETERS
+ *  pe  power state from s16_powexp_init() or s16_powexp_init_root().
+ *  a   base, a 16 bit integer having an implied binary point with 7 bits
+ *      of resolution, or an implied decimal point with two digits of
+ *      resolution.
+ * RETURN
+ *  The power, in the same format as a, as s16_powexp() returns it:
+ *  saturating to S16_MAX, or -S16_MAX for a negative base, and 0 where
+ *  it rounds to less than the least significant bit. 0 to a negative
+ *  power saturates.
+ * NOTES
+ *  log2(a) in Q26 as s16_powexp() takes it, one 32 by 32 bit product
+ *  with the prepared exponent, and the 2^x of s16_exp2(). The product
+ *  keeps 30 bits of the exponent where s16_powexp() splits it, so a
+ *  result may differ from that one by a least significant bit; each is
+ *  within one least significant bit of the power rounded to nearest.
+ */
+qm_n s16_powexp_pow(const s16_powexp_t *pe, qm_n a)
+{
+	s32 l,x;
+	u32 h,lo;
+	qm_n p;
+
+	if (!pe->e)
+		return UI;
+	if (!a)
+		return isneg(pe->e)?S16_MAX:0;
+	if (isneg(a) && !pe->neg)
+		return 0;
+	l=log2q26(abs((s32)a));
+	h=mul32((u32)abs(pe->e),(u32)abs(l),&lo);
+	if (pe->sh >= 0)
+		x=h >= (u32)POW_RANGE>>pe->sh?POW_RANGE:
+			(s32)((h<<pe->sh)|(pe->sh?lo>>(32-pe->sh):0));
+	else
+		x=(s32)(h>>-pe->sh);
+	if (x > POW_RANGE)
+		x=POW_RANGE;
+	p=exp2q20(isneg(pe->e) != isneg(l)?-x:x);
+	return isneg(a) && pe->neg == 2?-p:p;
+
+} /* End s16_powexp_pow () */
+
+/** s16_powexp_n - evaluate power of prepared exponent for an array
+ * DESCRIPTION
+ *  Computes r[i]=s16_powexp_pow(pe,a[i]) for 0 <= i < n.
+ * PARAMETERS
+ *  pe  power state from s16_powexp_init() or s16_powexp_init_root().
+ *  a   bases supplied as 16 bit integers having an implied binary point
+ *      with 7 bits of resolution, or an implied decimal point with two
+ *      digits of resolution.
+ *  r   receives the n powers, same format as a. r may be the same array
+ *      as a, but must not otherwise overlap it.
+ *  n   number of elements.
+ * RETURN
+ *  None.
+ */
+void s16_powexp_n(const s16_powexp_t *pe, const qm_n *a, qm_n *r, size_t n)
+{
+	size_t i;
+
+	for (i=0; i<n; i++)
+		r[i]=s16_powexp_pow(pe,a[i]);
+
+} /* End s16_powexp_n () */
+
+/** s16_logbase_init - prepare a logarithm base
+ * DESCRIPTION
+ *  Sets up lb to take logarithms to base a of any number of arguments,
+ *  with s16_logbase_log() or s16_logbase_n().
+ * PARAMETERS
+ *  lb  logarithm state.
+ *  a   base, a 16 bit integer having an implied binary point with 7 bits
+ *      of resolution, or an implied decimal point with two digits of
+ *      resolution.
+ * RETURN
+ *  None.
+ * NOTES
+ *  log2(a) is taken in Q26 as s16_powexp() takes it, and its reciprocal
+ *  to 30 bits, once here.
+ */
+void s16_logbase_init(s16_logbase_t *lb, qm_n a)
+{
+	s32 l;
+
+	lb->r=0;
+	lb->sh=0;
+	lb->nan=a <= 0;
+	/* log2q26(UI) is a few units off 0 */
+	if (lb->nan || a == UI)
+		return;
+	l=log2q26(a);
+	lb->r=(s32)normdiv(UI,(u32)abs(l),&lb->sh);
+	if (isneg(l))
+		lb->r=-lb->r;
+
+} /* End s16_logbase_init () */
+
+/** s16_logbase_log - logarithm to a prepared base
+ * DESCRIPTION
+ *  Evaluates the logarithm to the base a given to s16_logbase_init() of n.
+ * PARAMETERS
+ *  lb  logarithm state from s16_logbase_init().
+ *  n   argument, a 16 bit integer having an implied binary point with 7
+ *      bits of resolution, or an implied decimal point with two digits of
+ *      resolution.
+ * RETURN
+ *  The power to which a would have to be raised to yield n, in the same
+ *  format as n, within 0.53 least significant bits. Logarithms too large
+ *  to represent saturate to S16_MAX or -S16_MAX. A base of 1 gives 0, as
+ *  s16_log() does.
+ *
+ *  A return of -99.00 (S16_NAN) means a <= 0 or n <= 0.
+ * NOTES
+ *  log2(n) in Q26 and one product with 1/log2(a). s16_log() divides
+ *  s16_ln(n) by s16_ln(a), each already rounded to the least significant
+ *  bit, so for bases near 1 its results are far coarser than these, and
+ *  it wraps where these saturate.
+ */
+qm_n s16_logbase_log(const s16_logbase_t *lb, qm_n n)
+{
+	s32 l;
+	u32 h,lo;
+
+	if (lb->nan || n <= 0)
+		return S16_NAN;
+	if (!lb->r)
+		return 0;
+	l=log2q26(n);
+	/* |l|*r/2^sh, the 2^26 of both logarithms cancelling: sh is over 40 */
+	h=mul32((u32)abs(l),(u32)abs(lb->r),&lo);
+	h=(h+((u32)1<<(lb->sh-33)))>>(lb->sh-32);
+	if (h > S16_MAX)
+		h=S16_MAX;
+	return isneg(l) != isneg(lb->r)?-(qm_n)h:(qm_n)h;
+
+} /* End s16_logbase_log () */
+
+/** s16_logbase_n - logarithms of an array to a prepared base
+ * DESCRIPTION
+ *  Computes r[i]=s16_logbase_log(lb,n[i]) for 0 <= i < cnt.
+ * PARAMETERS
+ *  lb   logarithm state from s16_logbase_init().
+ *  n    arguments supplied as 16 bit integers having an implied binary
+ *       point with 7 bits of resolution, or an implied decimal point with
+ *       two digits of resolution.
+ *  r    receives the cnt logarithms, same format as n. r may be the same
+ *       array as n, but must not otherwise overlap it.
+ *  cnt  number of elements.
+ * RETURN
+ *  None.
+ */
+void s16_logbase_n(const s16_logbase_t *lb, const qm_n *n, qm_n *r, size_t cnt)
+{
+	size_t i;
+
+	for (i=0; i<cnt; i++)
+		r[i]=s16_logbase_log(lb,n[i]);
+
+} /* End s16_logbase_n () */
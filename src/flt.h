@@ -0,0 +1,87 @@
+/* vi:set ts=4: <-- vi tabstop
+   flt.h - 32 bit mantissa and exponent arithmetic for root.c and pow.c.
+   Copyright (c) 2014 Bryan Batten <bjbatten@acm.org>
+
+   Include after s16math.h.
+ */
+#ifndef FLT_H
+#define FLT_H
+
+typedef struct {
+	u32	m;						/* mantissa, 2^30 <= m < 2^31 */
+	s16	e;						/* value is m*2^(e-30) */
+} flt_t;
+
+/* bit number of the most significant one bit of 0 < a */
+static inline u8 msb(u32 a)
+{
+#ifdef __GNUC__
+	return (u8)(31-__builtin_clz(a));
+#else
+	u8 k=0;
+
+	while (a>>=1)
+		k++;
+	return k;
+#endif
+}
+
+/* m*2^(e-30) with the mantissa brought into range, for 0 < m */
+static inline flt_t fnorm(u32 m, s16 e)
+{
+	flt_t r;
+	u8 k=msb(m);
+
+	r.m=k > 30?m>>(k-30):m<<(30-k);
+	r.e=e+k-30;
+	return r;
+}
+
+/* product, the top 32 bits of the 62 bit one less the low by low part */
+static inline flt_t fmul(flt_t a, flt_t b)
+{
+	u32 ah=a.m>>16,al=a.m&0xffff,bh=b.m>>16,bl=b.m&0xffff;
+
+	return fnorm(ah*bh+((ah*bl)>>16)+((al*bh)>>16),a.e+b.e+2);
+}
+
+/* quotient, by long division by the top 24 bits of b, 7 bits a step */
+static inline flt_t fdiv(flt_t a, flt_t b)
+{
+	u32 d=b.m>>7,q=a.m/d,r=a.m%d;
+	u8 i;
+
+	for (i=0; i<2; i++) {
+		r<<=7;
+		q=(q<<7)+r/d;
+		r%=d;
+	}
+	return fnorm(q,a.e-b.e+9);
+}
+
+/* a/UI, for 0 < a <= 32768 */
+static inline flt_t fromqmn(u32 a)
+{
+	u8 k=msb(a);
+
+	return fnorm((a<<(31-k))/UI,(s16)k-1);
+}
+
+/* nearest qm_n to y, S16_MAX if it does not fit */
+static inline qm_n toqmn(flt_t y)
+{
+	u32 m=y.m;
+	s16 s=23-y.e;
+
+#ifndef USE_BINARY_POINT
+	m=(m>>7)*UI;				/* Q23, times 100 still fits */
+#endif
+	if (s < 1)
+		return S16_MAX;
+	if (s > 31)
+		return 0;
+	m=((m>>(s-1))+1)>>1;
+	return m > S16_MAX?S16_MAX:(qm_n)m;
+}
+
+#endif /* FLT_H */
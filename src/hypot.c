@@ -0,0 +1,185 @@
+/* vi:set ts=4: <-- vi tabstop
+   hypot.c - hypotenuse of a right triangle, or magnitude of a vector.
+   Copyright (c) 2014 Bryan Batten <bjbatten@acm.org>
+ */
+#include "cpu.h"		/* for S16_KERNEL () */
+#include "s16math.h"
+
+/* Both sides are in the same units, so the hypotenuse is the integer
+   square root of x^2+y^2 with no scaling. The sum is at most 2^31, which
+   fits in 32 bits unsigned. */
+
+typedef qm_n hypot_fn(qm_n x, qm_n y);
+typedef void hypot_n_fn(const qm_n *iq, qm_n *r, size_t n);
+
+/* sqrt(n) rounded to nearest, S16_MAX if it does not fit. Digit by digit,
+   two bits of n a step: 16 steps, and no multiply or divide. */
+static qm_n hypot_c(qm_n x, qm_n y)
+{
+	u32 n=(u32)((s32)x*x)+(u32)((s32)y*y),r=0,b=(u32)1<<30;
+
+	for (; b; b>>=2)
+		if (n >= r+b) {
+			n-=r+b;
+			r=(r>>1)+b;
+		} else r>>=1;
+	/* n is now x^2+y^2-r^2: round up past r^2+r */
+	r+=n > r;
+	return r > S16_MAX?S16_MAX:(qm_n)r;
+}
+
+/* Each array kernel does the elements it can, then hands the rest down. */
+static void hypot_n_c(const qm_n *iq, qm_n *r, size_t n)
+{
+	size_t i;
+
+	for (i=0; i<n; i++)
+		r[i]=hypot_c(iq[2*i],iq[2*i+1]);
+}
+
+#ifdef S16_SSE2
+S16_BEGIN_SSE2
+/* The double root of an integer below 2^32 is never within 2^-19 of a
+   half, so adding a half and truncating rounds to nearest. */
+static qm_n hypot_sse2(qm_n x, qm_n y)
+{
+	__m128d d;
+	s32 r;
+
+	d=_mm_set_sd((double)((u32)((s32)x*x)+(u32)((s32)y*y)));
+	r=_mm_cvttsd_si32(_mm_add_sd(_mm_sqrt_sd(d,d),_mm_set_sd(0.5)));
+	return r > S16_MAX?S16_MAX:(qm_n)r;
+}
+
+/* Four (x,y) pairs to four 32 bit hypotenuses. _mm_madd_epi16 sums the
+   squares of each pair; its only sum that wraps is 2^31, for two sides
+   of -32768, and 2^32 is added back to that one. */
+static __m128i hypot4(__m128i v)
+{
+	const __m128d h=_mm_set1_pd(0.5),w=_mm_set1_pd(4294967296.0);
+	__m128i s=_mm_madd_epi16(v,v);
+	__m128d d0=_mm_cvtepi32_pd(s);
+	__m128d d1=_mm_cvtepi32_pd(_mm_shuffle_epi32(s,_MM_SHUFFLE(1,0,3,2)));
+
+	d0=_mm_add_pd(d0,_mm_and_pd(_mm_cmplt_pd(d0,_mm_setzero_pd()),w));
+	d1=_mm_add_pd(d1,_mm_and_pd(_mm_cmplt_pd(d1,_mm_setzero_pd()),w));
+	return _mm_unpacklo_epi64(
+			_mm_cvttpd_epi32(_mm_add_pd(_mm_sqrt_pd(d0),h)),
+			_mm_cvttpd_epi32(_mm_add_pd(_mm_sqrt_pd(d1),h)));
+}
+
+/* eight pairs a step; the signed pack saturates to S16_MAX */
+static void hypot_n_sse2(const qm_n *iq, qm_n *r, size_t n)
+{
+	size_t i=0;
+
+	for (; i+8<=n; i+=8)
+		_mm_storeu_si128((__m128i *)(r+i),_mm_packs_epi32(
+			hypot4(_mm_loadu_si128((const __m128i *)(iq+2*i))),
+			hypot4(_mm_loadu_si128((const __m128i *)(iq+2*i+8)))));
+	hypot_n_c(iq+2*i,r+i,n-i);
+}
+S16_END
+#endif /* S16_SSE2 */
+
+#ifdef S16_AVX2
+S16_BEGIN_AVX2
+/* Eight pairs to eight 16 bit hypotenuses; same steps as hypot4(). */
+static __m128i hypot8(__m256i v)
+{
+	const __m256d h=_mm256_set1_pd(0.5),w=_mm256_set1_pd(4294967296.0);
+	__m256i s=_mm256_madd_epi16(v,v);
+	__m256d d0=_mm256_cvtepi32_pd(_mm256_castsi256_si128(s));
+	__m256d d1=_mm256_cvtepi32_pd(_mm256_extracti128_si256(s,1));
+
+	d0=_mm256_add_pd(d0,_mm256_and_pd(
+			_mm256_cmp_pd(d0,_mm256_setzero_pd(),_CMP_LT_OQ),w));
+	d1=_mm256_add_pd(d1,_mm256_and_pd(
+			_mm256_cmp_pd(d1,_mm256_setzero_pd(),_CMP_LT_OQ),w));
+	return _mm_packs_epi32(
+			_mm256_cvttpd_epi32(_mm256_add_pd(_mm256_sqrt_pd(d0),h)),
+			_mm256_cvttpd_epi32(_mm256_add_pd(_mm256_sqrt_pd(d1),h)));
+}
+
+static void hypot_n_avx2(const qm_n *iq, qm_n *r, size_t n)
+{
+	size_t i=0;
+
+	for (; i+8<=n; i+=8)
+		_mm_storeu_si128((__m128i *)(r+i),
+			hypot8(_mm256_loadu_si256((const __m256i *)(iq+2*i))));
+	hypot_n_sse2(iq+2*i,r+i,n-i);
+}
+S16_END
+#endif /* S16_AVX2 */
+
+#ifdef S16_DISPATCH
+static hypot_fn *resolve_hypot(void)
+{
+	return S16_KERNEL_SSE2(hypot);
+}
+
+static hypot_n_fn *resolve_hypot_n(void)
+{
+	return S16_KERNEL(hypot_n);
+}
+#endif
+
+/** s16_hypot - hypotenuse
+ * DESCRIPTION
+ *  Computes hypotenuse from adjacent and opposite sides of a right
+ *  triangle, or the magnitude of the vector (x, y).
+ * PARAMETERS
+ *  x, y  16 bit integers having an implied binary point with 7 bits of
+ *        resolution, or an implied decimal point with two digits of
+ *        resolution.
+ * RETURN
+ *  The hypotenuse rounded to nearest, in the same format as x. Values
+ *  too large to represent saturate to S16_MAX.
+ * NOTES
+ *  Replaces the s16math library version, which takes x^2 and y^2 with
+ *  s16_pow() and their root with s16_sqrt(), so it loses the low digits of
+ *  short sides and wraps or returns 0 once x^2+y^2 passes 327.67 (255.127).
+ *  This one sums the squares at 32 bits and takes their integer square root
+ *  digit by digit, in 16 shift and subtract steps, or where SSE2 is
+ *  available with one hardware square root. Every argument gives the
+ *  hypotenuse rounded to nearest.
+ */
+#ifdef S16_DISPATCH
+qm_n s16_hypot(qm_n x, qm_n y) S16_IFUNC(resolve_hypot);
+#else
+qm_n s16_hypot(qm_n x, qm_n y)
+{
+	return S16_KERNEL_SSE2(hypot)(x,y);
+
+} /* End s16_hypot () */
+#endif
+
+/** s16_hypot_n - magnitudes of an array of vectors
+ * DESCRIPTION
+ *  Computes r[i]=s16_hypot(iq[2*i],iq[2*i+1]) for 0 <= i < n: the
+ *  magnitudes of interleaved I/Q samples, or of any (x, y) pairs.
+ * PARAMETERS
+ *  iq  2*n numbers, x then y for each vector, supplied as 16 bit integers
+ *      having an implied binary point with 7 bits of resolution, or an
+ *      implied decimal point with two digits of resolution.
+ *  r   receives the n magnitudes, same format as iq. r may be the same
+ *      array as iq, but must not otherwise overlap it.
+ *  n   number of vectors.
+ * RETURN
+ *  None.
+ * NOTES
+ *  x86 builds pick a scalar, SSE2 or AVX2 kernel for the host when the
+ *  library is loaded; the SSE2 and AVX2 kernels take 8 vectors per step,
+ *  summing the squares of each pair with one multiply and add.
+ */
+#ifdef S16_DISPATCH
+void s16_hypot_n(const qm_n *iq, qm_n *r, size_t n)
+	S16_IFUNC(resolve_hypot_n);
+#else
+void s16_hypot_n(const qm_n *iq, qm_n *r, size_t n)
+{
+	S16_KERNEL(hypot_n)(iq,r,n);
+
+} /* End s16_hypot_n () */
+#endif
@@ -0,0 +1,176 @@
+/* vi:set ts=4: <-- vi tabstop
+   ln.c - evaluate natural logarithm.
+   Copyright (c) 2014 Bryan Batten <bjbatten@acm.org>
+ */
+#include "s16math.h"
+
+/* ln(a/UI) = k*ln(2) + ln(m) - ln(UI), where a = m*2^k with 1 <= m < 2.
+   ln(m) is interpolated from a table of ln(1+j/32), all in Q16. log2
+   works the same way, with log2(m) = ln(m)/ln(2). */
+#define LN_SHIFT		16
+#define LN_BITS			5				/* log2 of table intervals */
+#define LN2_Q16			((s32)45426)	/* ln(2) */
+#define LOG2E_Q14		((s32)23637)	/* 1/ln(2) */
+#ifdef USE_BINARY_POINT
+#define LNUI_Q16		(NSHIFT*LN2_Q16)/* ln(128) */
+#define LOG2UI_Q16		((s32)NSHIFT<<LN_SHIFT)	/* log2(128) */
+#else
+#define LNUI_Q16		((s32)301804)	/* ln(100) */
+#define LOG2UI_Q16		((s32)435412)	/* log2(100) */
+#define KQ16			((s32)1<<(LN_SHIFT-1))	/* half in Q16 */
+#endif
+
+/* ln(1+j/32) in Q16 */
+static const u16 lntab[(1<<LN_BITS)+1]={
+	0, 2017, 3973, 5873, 7719, 9515, 11262, 12965, 14624, 16242, 17821,
+	19364, 20870, 22343, 23783, 25193, 26573, 27924, 29248, 30546, 31818,
+	33067, 34292, 35494, 36675, 37835, 38975, 40095, 41196, 42280, 43345,
+	44394, 45426
+};
+
+/* bit number of the most significant one bit of 0 < a < 2^15 */
+static u8 msb(s16 a)
+{
+#ifdef __GNUC__
+	return (u8)(31-__builtin_clz((unsigned)a));
+#else
+	u8 k=0;
+
+	if (a & 0x7f00) {
+		a>>=8;
+		k+=8;
+	}
+	if (a & 0xf0) {
+		a>>=4;
+		k+=4;
+	}
+	if (a & 0xc) {
+		a>>=2;
+		k+=2;
+	}
+	return k+(a>>1);
+#endif
+}
+
+/* ln of the mantissa of 0 < a, in Q16, and its exponent in *k */
+static s32 lnm(qm_n a, u8 *k)
+{
+	s32 l,f;
+
+	*k=msb(a);
+	/* mantissa fraction in Q15: 5 bit index, 10 bit remainder */
+	f=((s32)a<<(15-*k))-((s32)1<<15);
+	l=lntab[f>>(15-LN_BITS)];
+	l+=((lntab[(f>>(15-LN_BITS))+1]-l)*(f&((1<<(15-LN_BITS))-1)))
+		>>(15-LN_BITS);
+	return l;
+}
+
+/* Q16 to qm_n, rounded */
+static qm_n toqmn(s32 l)
+{
+#ifdef USE_BINARY_POINT
+	return (qm_n)((l+((s32)1<<(LN_SHIFT-NSHIFT-1)))>>(LN_SHIFT-NSHIFT));
+#else
+	l*=UI;
+	return (qm_n)((l+(isneg(l)?-KQ16:KQ16))/((s32)1<<LN_SHIFT));
+#endif
+}
+
+/** s16_ln - natural logarithm
+ * DESCRIPTION
+ *  Evaluates log_e(a), where 0 < a <= 327.67 (decimal resolution), or
+ *  255.127 (Q8.7).
+ * PARAMETER
+ *  a  The number.
+ * RETURN
+ *  If 0 < a <= 255.127 (327.67), then the return value is the number to
+ *  which e would have to be raised to yield a.
+ *
+ *  A return of -99.00 (S16_NAN) means a <= 0. By convention, a = 327.68
+ *  (256.000) is taken to be -327.68 (-256.000) and results in an error
+ *  return.
+ * NOTES
+ *  Replaces the s16math library version, which sums a series with an
+ *  s16_mul() and an s16_div() per term. This one normalizes a by its
+ *  leading zero count, interpolates ln of the mantissa from a 33 entry
+ *  table and adds k*ln(2): the same few operations for every argument.
+ *  Results are within 0.01 of the reference implementation. The prebuilt
+ *  s16_log() and s16_log10() call s16_ln(), and s16mathx supplies them
+ *  too, so both use this version.
+ */
+qm_n s16_ln(qm_n a)
+{
+	s32 l;
+	u8 k;
+
+	if (a <= 0)
+		return S16_NAN;
+	l=lnm(a,&k);
+	return toqmn(l+k*LN2_Q16-LNUI_Q16);
+
+} /* End s16_ln () */
+
+/** s16_ln_p - natural logarithm to a given precision
+ * DESCRIPTION
+ *  Evaluates log_e(a) as s16_ln() does, from fewer of its terms, for
+ *  callers that need only a digit or two.
+ * PARAMETERS
+ *  a      The number.
+ *  terms  0 takes ln(a) as k*ln(2) - ln(UI) for the exponent k of a, as
+ *         if its mantissa were 1; 1 adds ln(1+j/32) for the top 5 bits j
+ *         of the mantissa fraction; 2 or more adds the interpolation
+ *         between table entries, giving the s16_ln() result.
+ * RETURN
+ *  As for s16_ln(). A return of -99.00 (S16_NAN) means a <= 0.
+ * NOTES
+ *  Each term drops the error bound: 0.70 for the exponent alone, 0.035
+ *  with the table entry, and under 0.01 with the interpolation. The
+ *  exponent alone takes no table read and the table entry no multiply.
+ */
+qm_n s16_ln_p(qm_n a, u8 terms)
+{
+	s32 l=0;
+	u8 k;
+
+	if (a <= 0)
+		return S16_NAN;
+	if (terms >= 2)
+		l=lnm(a,&k);
+	else {
+		k=msb(a);
+		if (terms)
+			l=lntab[((a<<(15-k))>>(15-LN_BITS))&((1<<LN_BITS)-1)];
+	}
+	return toqmn(l+k*LN2_Q16-LNUI_Q16);
+
+} /* End s16_ln_p () */
+
+/** s16_log2 - binary logarithm
+ * DESCRIPTION
+ *  Evaluates log to base 2 of a, where 0 < a <= 327.67 (decimal
+ *  resolution), or 255.127 (Q8.7).
+ * PARAMETER
+ *  a  The number.
+ * RETURN
+ *  If 0 < a, the return value is the number to which 2 would have to be
+ *  raised to yield a.
+ *
+ *  A return of -99.00 (S16_NAN) means a <= 0, as for s16_ln(), and
+ *  s16_logov() detects it.
+ * NOTES
+ *  The exponent of a is exact; the log of its mantissa is the s16_ln()
+ *  table value times 1/ln(2). Results are within one least significant
+ *  bit of the reference.
+ */
+qm_n s16_log2(qm_n a)
+{
+	s32 l;
+	u8 k;
+
+	if (a <= 0)
+		return S16_NAN;
+	l=(lnm(a,&k)*LOG2E_Q14)>>14;
+	return toqmn(l+((s32)k<<LN_SHIFT)-LOG2UI_Q16);
+
+} /* End s16_log2 () */
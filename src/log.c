@@ -0,0 +1,39 @@
+/* vi:set ts=4: <-- vi tabstop
+   log.c - evaluate log to arbitrary base.
+   Copyright (c) 2014 Bryan Batten <bjbatten@acm.org>
+ */
+#include "s16math.h"
+
+/** s16_log - log to arbitrary base
+ * DESCRIPTION
+ *  Evaluates log to base a of n, where 0 < n <= 327.67 (decimal
+ *  resolution), or 255.127 (Q8.7). The logarithm is evaluated as
+ *  s16_ln(n)/s16_ln(a).
+ * PARAMETERS
+ *  a  base of logarithm.
+ *  n  numeric argument.
+ * RETURN
+ *  If 0 < n <= 327.67 (255.127 if binary resolution), then the return
+ *  value is the number to which base a would have to be raised to yield
+ *  n.
+ *
+ *  A return of -99.00 (S16_NAN) means a <= 0 or n <= 0.
+ * NOTES
+ *  A copy of the s16math library version. That one resolves s16_ln()
+ *  inside its own archive, so both logarithms of the quotient would come
+ *  from the old s16_ln(); built here, they come from the s16mathx one.
+ *  Each logarithm is still rounded before s16_div() divides them; see
+ *  s16_logbase_log() for a base used more than once.
+ */
+qm_n s16_log(qm_n a, qm_n n)
+{
+	qm_n ln_n=s16_ln(n),ln_a;
+
+	if (ln_n == S16_NAN)
+		return ln_n;
+	ln_a=s16_ln(a);
+	if (ln_a == S16_NAN)
+		return ln_a;
+	return s16_div(ln_n,ln_a);
+
+} /* End s16_log () */
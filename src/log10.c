@@ -0,0 +1,35 @@
+/* vi:set ts=4: <-- vi tabstop
+   log10.c - evaluate common logarithm.
+   Copyright (c) 2014 Bryan Batten <bjbatten@acm.org>
+ */
+#include "s16math.h"
+
+/** s16_log10 - common logarithm
+ * DESCRIPTION
+ *  Evaluates log to base 10 of a, where 0 < a <= 327.67 (decimal
+ *  resolution), or 255.127 (binary resolution). The logarithm is evaluated
+ *  as s16_ln(a)/ln(10). A constant is used for ln(10).
+ * PARAMETER
+ *  a  numeric argument with equivalent of two decimal digits or seven
+ *     binary bits of resolution.
+ * RETURN
+ *  If 0 < a <= 327.67, then the return value is the number to which 10
+ *  would have to be raised to yield a.
+ *
+ *  A return of -99.00 (S16_NAN) means a <= 0.
+ * NOTES
+ *  Only the s16_ln() call differs from the s16math library version: built
+ *  in s16mathx it reaches the normalize and table s16_ln() rather than
+ *  the prebuilt one, so the common logarithm, and the log10 table of
+ *  s16_log10_lut(), gain its accuracy. The division by S16_LN10 is the
+ *  same.
+ */
+qm_n s16_log10(qm_n a)
+{
+	qm_n l=s16_ln(a);
+
+	if (l == S16_NAN)
+		return l;
+	return s16_div(l,S16_LN10);
+
+} /* End s16_log10 () */
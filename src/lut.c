@@ -0,0 +1,174 @@
+/* vi:set ts=4: <-- vi tabstop
+   lut.c - table driven unary functions.
+   Copyright (c) 2014 Bryan Batten <bjbatten@acm.org>
+ */
+#include <fcntl.h>		/* for open () */
+#include <string.h>		/* for memcmp () */
+#include <sys/mman.h>	/* for mmap () */
+#include <sys/stat.h>	/* for fstat () */
+#include <unistd.h>		/* for close () */
+#include "s16math.h"
+#include "lut.h"
+
+/* Every unary function maps a 16 bit argument to a 16 bit result, so one
+   65536 entry table (128 KiB) holds all of its results. s16_<f>_lut(x)
+   returns tab_<f>[(u16)x], which is s16_<f>(x) by construction.
+   s16_sincos_lut() does the same with a table of packed 32 bit results.
+
+   tabp_<f> points to the table in use, or is null until one is ready.
+   S16_LUT_EAGER builds point it at const tables that mklut generated from
+   the s16mathx functions at build time. Otherwise each table is filled on
+   first use: the first caller claims the table and fills it, and callers
+   that find it being filled call s16_<f>() directly, so no caller waits or
+   locks. s16_lut_map() points all of them at a shared table file. */
+
+#ifdef S16_LUT_EAGER
+#include "lut_tab.h"
+
+#define LUT(f)	static const s16 *tabp_##f=tab_##f;
+LUT_FUNCS
+#undef LUT
+static const s32 *tabp_sincos=tab_sincos;
+
+#define lookup(f,x)		(__atomic_load_n(&tabp_##f,__ATOMIC_ACQUIRE)[(u16)(x)])
+
+#else /* lazy */
+#define EMPTY		0
+#define FILLING		1
+
+#define LUT(f)								\
+static s16 tab_##f[LUT_ENTRIES];			\
+static const s16 *tabp_##f;					\
+static u8 state_##f;
+LUT_FUNCS
+#undef LUT
+static s32 tab_sincos[LUT_ENTRIES];
+static const s32 *tabp_sincos;
+static u8 state_sincos;
+
+/* Claim an empty table and fill it, or compute the one result. */
+static int claim(u8 *state)
+{
+	u8 expect=EMPTY;
+
+	return __atomic_compare_exchange_n(state,&expect,FILLING,0,
+			__ATOMIC_ACQUIRE,__ATOMIC_RELAXED);
+}
+
+static s16 fill16(s16 *tab, const s16 **tabp, u8 *state, s16 (*fn)(s16),
+				  s16 x)
+{
+	u32 i;
+
+	if (!claim(state))
+		return fn(x);
+	for (i=0; i<LUT_ENTRIES; i++)
+		tab[i]=fn((s16)(u16)i);
+	__atomic_store_n(tabp,tab,__ATOMIC_RELEASE);
+	return tab[(u16)x];
+}
+
+static s32 fill32(s32 *tab, const s32 **tabp, u8 *state, s32 (*fn)(s16),
+				  s16 x)
+{
+	u32 i;
+
+	if (!claim(state))
+		return fn(x);
+	for (i=0; i<LUT_ENTRIES; i++)
+		tab[i]=fn((s16)(u16)i);
+	__atomic_store_n(tabp,tab,__ATOMIC_RELEASE);
+	return tab[(u16)x];
+}
+
+#define lookup(f,x)		(lookup_##f(x))
+#define LUT(f)								\
+static s16 lookup_##f(s16 x)				\
+{											\
+	const s16 *t=__atomic_load_n(&tabp_##f,__ATOMIC_ACQUIRE);	\
+	return t?t[(u16)x]:fill16(tab_##f,&tabp_##f,&state_##f,s16_##f,x);\
+}
+LUT_FUNCS
+#undef LUT
+
+static s32 lookup_sincos(s16 x)
+{
+	const s32 *t=__atomic_load_n(&tabp_sincos,__ATOMIC_ACQUIRE);
+	return t?t[(u16)x]:fill32(tab_sincos,&tabp_sincos,&state_sincos,
+							  s16_sincos,x);
+}
+#endif /* lazy */
+
+#define LUT(f)								\
+qm_n s16_##f##_lut(qm_n x)					\
+{											\
+	return lookup(f,x);						\
+}
+LUT_FUNCS
+#undef LUT
+
+s32 s16_sincos_lut(qm_rad phi)
+{
+	return lookup(sincos,phi);
+
+} /* End s16_sincos_lut () */
+
+/** s16_lut_map - use a shared table file
+ * DESCRIPTION
+ *  Maps the table file written by mklut read only and shared, checks it,
+ *  then points every s16_<f>_lut() function at its tables. Processes that
+ *  map the same file share one copy of its pages, and none of them
+ *  computes a table.
+ * PARAMETERS
+ *  path  name of the table file.
+ * RETURN
+ *  0 on success. -1 if the file cannot be opened or mapped, -2 if its
+ *  version, build flags, byte order, resolution or size does not match
+ *  this library, -3 if its checksum is wrong. The tables in use are
+ *  unchanged on error.
+ * NOTES
+ *  The file stays mapped for the life of the process.
+ */
+s16 s16_lut_map(const char *path)
+{
+	const lutf_hdr_t *h;
+	const s16 *t;
+	struct stat st;
+	void *p;
+	int fd;
+
+	if ((fd=open(path,O_RDONLY)) < 0)
+		return -1;
+	if (fstat(fd,&st)) {
+		close(fd);
+		return -1;
+	}
+	if (st.st_size != (off_t)LUTF_SIZE) {
+		close(fd);
+		return -2;
+	}
+	p=mmap(NULL,LUTF_SIZE,PROT_READ,MAP_SHARED,fd,0);
+	close(fd);
+	if (p == MAP_FAILED)
+		return -1;
+	h=p;
+	if (memcmp(h->magic,LUTF_MAGIC,sizeof h->magic) || h->order!=LUTF_ORDER
+		|| h->version!=LUTF_VERSION || h->flags!=LUTF_FLAGS || h->unit!=UI
+		|| h->ntabs!=LUT_NTABS || h->entries!=LUT_ENTRIES) {
+		munmap(p,LUTF_SIZE);
+		return -2;
+	}
+	t=(const s16 *)(h+1);
+	if (lut_sum((const u16 *)t,(LUTF_SIZE-sizeof *h)/sizeof(u16)) != h->sum) {
+		munmap(p,LUTF_SIZE);
+		return -3;
+	}
+#define LUT(f)								\
+	__atomic_store_n(&tabp_##f,t,__ATOMIC_RELEASE);	\
+	t+=LUT_ENTRIES;
+	LUT_FUNCS
+#undef LUT
+	__atomic_store_n(&tabp_sincos,(const s32 *)t,__ATOMIC_RELEASE);
+	return 0;
+
+} /* End s16_lut_map () */
@@ -0,0 +1,86 @@
+/* vi:set ts=4: <-- vi tabstop
+   lut.h - unary functions given 65536 entry tables by lut.c.
+   Copyright (c) 2014 Bryan Batten <bjbatten@acm.org>
+ */
+#ifndef LUT_H
+#define LUT_H
+
+#define LUT_ENTRIES		65536u		/* one entry per 16 bit argument */
+
+/* X macro list: LUT(name) for each s16_<name>() with a 16 bit table.
+   s16_sincos() has a 32 bit table of its own after these. */
+#define LUT_FUNCS	\
+	LUT(sin)		\
+	LUT(cos)		\
+	LUT(tan)		\
+	LUT(atan)		\
+	LUT(asin)		\
+	LUT(acos)		\
+	LUT(ln)			\
+	LUT(log10)		\
+	LUT(sqrt)		\
+	LUT(round)		\
+	LUT(todeg)		\
+	LUT(torad)
+#define LUT_NTABS		12			/* entries in LUT_FUNCS */
+
+/* Table file written by mklut and mapped by s16_lut_map(). The header is
+   followed by the LUT_FUNCS tables in order, then the s16_sincos() table.
+   All fields are in the byte order of the machine that wrote the file.
+   LUTF_VERSION goes up whenever the layout changes or a function in the
+   tables returns different results, so a file from an older library is
+   refused rather than used:
+	1	first version
+	2	flags word
+	3	s16_ln() and s16_log10() from the s16mathx ln.c
+	4	s16_tan() from the s16mathx trig.c
+	5	s16_asin() and s16_acos() from the s16mathx asin.c */
+#define LUTF_MAGIC		"S16MATHT"
+#define LUTF_VERSION	5
+#define LUTF_ORDER		0x0102		/* reads 0x0201 if byte swapped */
+
+/* flags: build options that change what the tables hold */
+#define LUTF_ATAN_CORDIC	0x0001	/* ATAN=cordic, s16_atan_cordic() */
+#ifdef S16_ATAN_CORDIC
+#define LUTF_FLAGS		LUTF_ATAN_CORDIC
+#else
+#define LUTF_FLAGS		0
+#endif
+
+typedef struct {
+	char	magic[8];		/* LUTF_MAGIC, no terminator */
+	u16		version;		/* LUTF_VERSION */
+	u16		order;			/* LUTF_ORDER */
+	u16		unit;			/* UI: 128 binary, 100 decimal resolution */
+	u16		ntabs;			/* LUT_NTABS */
+	u32		entries;		/* LUT_ENTRIES */
+	u32		sum;			/* lut_sum() of the tables */
+	u32		flags;			/* LUTF_FLAGS of the build that wrote it */
+	u32		pad;			/* keeps the tables 32 byte aligned */
+} lutf_hdr_t;
+
+#define LUTF_SIZE	(sizeof(lutf_hdr_t)+LUT_NTABS*LUT_ENTRIES*sizeof(s16)\
+					 +LUT_ENTRIES*sizeof(s32))
+
+/* Fletcher-32 of n 16 bit words */
+static inline u32 lut_sum(const u16 *p, size_t n)
+{
+	u32 a=0xffff,b=0xffff;
+	size_t k;
+
+	while (n) {
+		k=n>359?359:n;		/* largest block that cannot overflow b */
+		n-=k;
+		while (k--) {
+			a+=*p++;
+			b+=a;
+		}
+		a=(a&0xffff)+(a>>16);
+		b=(b&0xffff)+(b>>16);
+	}
+	a=(a&0xffff)+(a>>16);
+	b=(b&0xffff)+(b>>16);
+	return b<<16|a;
+}
+
+#endif /* LUT_H */
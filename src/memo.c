@@ -0,0 +1,206 @@
+/* vi:set ts=4: <-- vi tabstop
+   memo.c - per thread memo cache for s16_pow and s16_root.
+   Copyright (c) 2014 Bryan Batten <bjbatten@acm.org>
+ */
+#include <stdlib.h>		/* for calloc () */
+#include "s16math.h"
+
+/* Programs that raise the same few (a, n) pairs again and again, a gamma
+   curve or a power law sensor correction, can keep the results in a
+   direct mapped table: entry h(a,n) holds the last pair that hashed
+   there and its result. Each thread has its own table and counters, so
+   a lookup takes no lock and touches no line another core writes. A
+   thread without a table, the default, calls straight through. */
+#ifdef __GNUC__
+/* 24 bytes fit the static TLS space kept for libraries loaded later, and
+   initial-exec saves a __tls_get_addr() call a lookup */
+#define S16_TLS		__thread __attribute__((tls_model("initial-exec")))
+#else
+#define S16_TLS		_Thread_local
+#endif
+
+#define MEMO_EMPTY	0
+#define MEMO_POW	1
+#define MEMO_ROOT	2
+#define MEMO_HASH	2654435769u		/* 2^32/golden ratio, odd */
+#define MEMO_MIX	0x2c1b3c6du		/* odd, scatters bits upward */
+
+typedef struct {
+	u32		key;		/* a in bits 16:31, n in bits 0:15 */
+	qm_n	r;			/* result */
+	u8		fn;			/* MEMO_POW, MEMO_ROOT or MEMO_EMPTY */
+} memo_t;
+
+/* one thread local block, so each call finds its address once */
+static S16_TLS struct {
+	memo_t	*tab;		/* null: no table */
+	u32		hits;
+	u32		misses;
+	u8		shift;		/* 32 less log2 of the entries */
+} memo;
+
+/* Slot of a key. The golden ratio multiply alone spreads consecutive
+   bases perfectly, but its top bits are then a function of a times the
+   low half of MEMO_HASH, and bases a fixed stride apart pile into a few
+   slots for many strides: at 7 apart, 256 bases share 123 of 1024
+   slots. Folding high bits down and multiplying once first makes every
+   bit of the key reach the top bits, so bases of any spacing, 1 apart
+   included, land about as random keys would. */
+static u32 slot(u32 key)
+{
+	key^=key>>15;
+	key*=MEMO_MIX;
+	key^=key>>12;
+	return (key*MEMO_HASH)>>memo.shift;
+
+} /* End slot () */
+
+/* Look (a,n) up for fn, and on a miss compute it with f and keep it. The
+   function number is folded into the hash, so s16_pow and s16_root share
+   one table without taking each other's entries for the same pair. */
+static qm_n lookup(u8 fn, qm_n (*f)(qm_n, qm_n), qm_n a, qm_n n)
+{
+	u32 key=(u32)(u16)a<<16|(u16)n;
+	memo_t *m;
+
+	if (!memo.tab) {
+		memo.misses++;
+		return f(a,n);
+	}
+	m=memo.tab+slot(key^fn);
+	if (m->fn == fn && m->key == key) {
+		memo.hits++;
+		return m->r;
+	}
+	memo.misses++;
+	m->key=key;
+	m->r=f(a,n);
+	m->fn=fn;
+	return m->r;
+
+} /* End lookup () */
+
+/** s16_memo_init - give this thread a memo cache
+ * DESCRIPTION
+ *  Allocates a direct mapped table of 2^bits entries for the calling
+ *  thread's s16_pow_memo() and s16_root_memo() calls, and zeroes its hit
+ *  and miss counts. A table the thread already has is freed first.
+ * PARAMETER
+ *  bits  log2 of the number of entries, 1 through 20. 0 frees the table,
+ *        as s16_memo_free() does.
+ * RETURN
+ *  0 on success. -1 if bits is out of range or the table cannot be
+ *  allocated; the thread is then left without a table, and its calls
+ *  go straight to s16_pow() and s16_root().
+ * NOTES
+ *  Each thread has its own table and counters, so a lookup takes no lock
+ *  and touches no cache line another core writes. An entry is 8 bytes, so
+ *  the 10 bits bench uses are 8 KiB a thread. Each thread must call
+ *  s16_memo_free() before it exits. Define S16_USE_MEMO before including
+ *  s16math.h to have s16_pow() and s16_root() calls use the cache.
+ */
+s16 s16_memo_init(u8 bits)
+{
+	s16_memo_free();
+	memo.hits=memo.misses=0;
+	if (!bits)
+		return 0;
+	if (bits > 20)
+		return -1;
+	memo.tab=calloc((size_t)1<<bits,sizeof *memo.tab);
+	if (!memo.tab)
+		return -1;
+	memo.shift=(u8)(32-bits);
+	return 0;
+
+} /* End s16_memo_init () */
+
+/** s16_memo_free - release this thread's memo cache
+ * DESCRIPTION
+ *  Frees the calling thread's table, if it has one. Its later
+ *  s16_pow_memo() and s16_root_memo() calls go straight through. The
+ *  hit and miss counts are kept.
+ * PARAMETERS
+ *  None.
+ * RETURN
+ *  None.
+ */
+void s16_memo_free(void)
+{
+	free(memo.tab);
+	memo.tab=NULL;
+
+} /* End s16_memo_free () */
+
+/** s16_memo_stats - memo cache hit and miss counts
+ * DESCRIPTION
+ *  Reports the calling thread's s16_pow_memo() and s16_root_memo()
+ *  calls since its last s16_memo_init(), those answered from the table
+ *  and those computed.
+ * PARAMETERS
+ *  hits    receives the count of calls answered from the table, or null.
+ *  misses  receives the count of calls computed, or null. Calls made
+ *          without a table count as misses.
+ * RETURN
+ *  None.
+ * NOTES
+ *  The counts are 32 bits and wrap.
+ */
+void s16_memo_stats(u32 *hits, u32 *misses)
+{
+	if (hits)
+		*hits=memo.hits;
+	if (misses)
+		*misses=memo.misses;
+
+} /* End s16_memo_stats () */
+
+/** s16_pow_memo - evaluate power through the memo cache
+ * DESCRIPTION
+ *  Evaluates a^n as s16_pow() does, returning the result the calling
+ *  thread's table holds for (a, n) if it has one.
+ * PARAMETERS
+ *  The parameters are 16 bit integers having an implied binary point with
+ *  7 bits of resolution, or an implied decimal point with two digits of
+ *  resolution.
+ *  a  base.
+ *  n  exponent.
+ * RETURN
+ *  s16_pow(a,n).
+ * NOTES
+ *  The pair is packed into a 32 bit key and hashed to one entry. A hit is
+ *  the hash, one compare and a load, a few ns; a miss adds those to the
+ *  s16_pow() call and replaces the entry. Pairs that hash to one entry
+ *  evict each other on every use; the key is mixed before it is hashed,
+ *  so bases collide about as often as random ones whatever their
+ *  spacing, and about 3 in 4 of 256 levels have an entry to themselves
+ *  in a 1024 entry table. The bench example times a gamma curve both
+ *  ways, and on bases 7 apart.
+ */
+qm_n s16_pow_memo(qm_n a, qm_n n)
+{
+	return lookup(MEMO_POW,s16_pow,a,n);
+
+} /* End s16_pow_memo () */
+
+/** s16_root_memo - evaluate root through the memo cache
+ * DESCRIPTION
+ *  Evaluates the nth root of a as s16_root() does, returning the result
+ *  the calling thread's table holds for (a, n) if it has one.
+ * PARAMETERS
+ *  The parameters are 16 bit integers having an implied binary point with
+ *  7 bits of resolution, or an implied decimal point with two digits of
+ *  resolution.
+ *  a  radicand.
+ *  n  index.
+ * RETURN
+ *  s16_root(a,n).
+ * NOTES
+ *  The table is shared with s16_pow_memo(), each entry marked with the
+ *  function that made it.
+ */
+qm_n s16_root_memo(qm_n a, qm_n n)
+{
+	return lookup(MEMO_ROOT,s16_root,a,n);
+
+} /* End s16_root_memo () */
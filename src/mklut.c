@@ -0,0 +1,84 @@
+/* vi:set ts=4: <-- vi tabstop
+   mklut.c - generate lut.c tables from the s16mathx functions.
+   Copyright (c) 2014 Bryan Batten <bjbatten@acm.org>
+
+   Runs on the build host. It is built from the s16mathx sources whose
+   results differ from the prebuilt library's, asin.c, atan.c, ln.c and
+   trig.c, linked ahead of the prebuilt s16math library, so each table
+   holds what the s16mathx function returns.
+   With no argument, prints a C header with one const table per LUT_FUNCS
+   entry and one for s16_sincos(), for an eager lut.c build. With a file
+   name, writes the same tables as a table file for s16_lut_map().
+ */
+#include <stdio.h>		/* for printf */
+#include <stdlib.h>		/* for exit () */
+#include <string.h>		/* for memcpy () */
+#include "s16math.h"	/* for 16 bit fixed point math library functions */
+#include "lut.h"		/* for LUT_FUNCS, lutf_hdr_t */
+
+static void table(const char *name, s16 (*fn)(s16))
+{
+	u32 i;
+
+	printf("static const s16 tab_%s[LUT_ENTRIES]={", name);
+	for (i=0; i<LUT_ENTRIES; i++)
+		printf("%s%d%s", i%16?"":"\n\t", fn((s16)(u16)i),
+			   i+1<LUT_ENTRIES?",":"\n};\n");
+}
+
+static void header(void)
+{
+	u32 i;
+
+	printf("/* Generated by mklut.c from the s16mathx functions. */\n");
+#define LUT(f)	table(#f,s16_##f);
+	LUT_FUNCS
+#undef LUT
+	printf("static const s32 tab_sincos[LUT_ENTRIES]={");
+	for (i=0; i<LUT_ENTRIES; i++)
+		printf("%s%ld%s", i%8?"":"\n\t", (long)s16_sincos((s16)(u16)i),
+			   i+1<LUT_ENTRIES?",":"\n};\n");
+}
+
+static int tabfile(const char *path)
+{
+	static u16 buf[(LUTF_SIZE-sizeof(lutf_hdr_t))/sizeof(u16)];
+	lutf_hdr_t h;
+	s16 *t=(s16 *)buf;
+	s32 sc;
+	u32 i;
+	FILE *fp;
+
+#define LUT(f)										\
+	for (i=0; i<LUT_ENTRIES; i++)					\
+		*t++=s16_##f((s16)(u16)i);
+	LUT_FUNCS
+#undef LUT
+	for (i=0; i<LUT_ENTRIES; i++, t+=2) {
+		sc=s16_sincos((s16)(u16)i);
+		memcpy(t,&sc,sizeof sc);
+	}
+	memset(&h,0,sizeof h);
+	memcpy(h.magic,LUTF_MAGIC,sizeof h.magic);
+	h.version=LUTF_VERSION;
+	h.order=LUTF_ORDER;
+	h.unit=UI;
+	h.ntabs=LUT_NTABS;
+	h.entries=LUT_ENTRIES;
+	h.flags=LUTF_FLAGS;
+	h.sum=lut_sum(buf,sizeof buf/sizeof(u16));
+	if (!(fp=fopen(path,"wb")) || fwrite(&h,sizeof h,1,fp) != 1
+		|| fwrite(buf,sizeof buf,1,fp) != 1 || fclose(fp)) {
+		perror(path);
+		return 1;
+	}
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+	if (argc > 1)
+		return tabfile(argv[1]);
+	header();
+	return 0;
+
+} /* End main () */
@@ -0,0 +1,34 @@
+/* vi:set ts=4: <-- vi tabstop
+   mul.c - multiply.
+   Copyright (c) 2014 Bryan Batten <bjbatten@acm.org>
+ */
+#include "s16math.h"
+
+/** s16_mul - multiply
+ * DESCRIPTION
+ *  Computes product of two numbers.
+ * PARAMETERS
+ *  a  the first parameter is the multiplicand supplied as a 16 bit
+ *     integer having an implied binary point with 7 bits of resolution, or
+ *     an implied decimal point with two digits of resolution.
+ *  b  the second parameter is the multiplier supplied as a 16 bit
+ *     integer having an implied binary point with 7 bits of resolution, or
+ *     an implied decimal point with two digits of resolution.
+ * RETURN
+ *  The return value is the 16 bit product represented as an integer having
+ *  an implied binary point with 7 bits of resolution, or an implied
+ *  decimal point with two digits of resolution.
+ *  Range is -327.68 through 327.67 (-256.000 through 255.127).
+ * NOTES
+ *  Internal 32 bit intermediate results. Replaces the s16math library
+ *  version with the same results; one multiply has no faster SSE2 or AVX2
+ *  form, so there is a single kernel, built with the library's -march.
+ */
+qm_n s16_mul(qm_n a, qm_n b)
+{
+	s32 p=(s32)a*b;
+
+	p=nround(p);
+	return (qm_n)fixscale(p);
+
+} /* End s16_mul () */
@@ -0,0 +1,153 @@
+/* vi:set ts=4: <-- vi tabstop
+   mul_n.c - multiply arrays of fixed point numbers.
+   Copyright (c) 2014 Bryan Batten <bjbatten@acm.org>
+ */
+#include "cpu.h"		/* for S16_KERNEL () */
+#include "s16math.h"
+
+/* Same arithmetic as s16_mul(): 32 bit product, round, scale down. */
+#define mul1(a,b)	((qm_n)fixscale(nround((s32)(a)*(b))))
+
+typedef void mul_n_fn(const qm_n *a, const qm_n *b, qm_n *p, size_t n);
+
+/* Each kernel does the elements it can, then hands the rest down. */
+static void mul_n_c(const qm_n *a, const qm_n *b, qm_n *p, size_t n)
+{
+	size_t i;
+
+	for (i=0; i<n; i++)
+		p[i]=mul1(a[i],b[i]);
+}
+
+#ifdef S16_SSE2
+S16_BEGIN_SSE2
+/* Eight products per call. Binary resolution rounds and shifts each 32 bit
+   product; decimal resolution divides the rounded magnitude by 100 using
+   the multiplicative inverse 0x51eb851f/2^37, exact for |p| < 2^31. */
+static __m128i mul8(__m128i a, __m128i b)
+{
+	__m128i lo=_mm_mullo_epi16(a,b);
+	__m128i hi=_mm_mulhi_epi16(a,b);
+	__m128i p0=_mm_unpacklo_epi16(lo,hi);
+	__m128i p1=_mm_unpackhi_epi16(lo,hi);
+#ifdef USE_BINARY_POINT
+	/* nround() reduces to +KN for either sign */
+	p0=_mm_srai_epi32(_mm_add_epi32(p0,_mm_set1_epi32(KN)),NSHIFT);
+	p1=_mm_srai_epi32(_mm_add_epi32(p1,_mm_set1_epi32(KN)),NSHIFT);
+#else
+	const __m128i inv=_mm_set1_epi32(0x51eb851f);
+	__m128i s0=_mm_srai_epi32(p0,31);
+	__m128i s1=_mm_srai_epi32(p1,31);
+	__m128i m0=_mm_add_epi32(_mm_sub_epi32(_mm_xor_si128(p0,s0),s0),
+							 _mm_set1_epi32(KN));
+	__m128i m1=_mm_add_epi32(_mm_sub_epi32(_mm_xor_si128(p1,s1),s1),
+							 _mm_set1_epi32(KN));
+	__m128i q0e=_mm_srli_epi64(_mm_mul_epu32(m0,inv),37);
+	__m128i q0o=_mm_srli_epi64(_mm_mul_epu32(_mm_srli_epi64(m0,32),inv),37);
+	__m128i q1e=_mm_srli_epi64(_mm_mul_epu32(m1,inv),37);
+	__m128i q1o=_mm_srli_epi64(_mm_mul_epu32(_mm_srli_epi64(m1,32),inv),37);
+	p0=_mm_or_si128(q0e,_mm_slli_epi64(q0o,32));
+	p1=_mm_or_si128(q1e,_mm_slli_epi64(q1o,32));
+	p0=_mm_sub_epi32(_mm_xor_si128(p0,s0),s0);
+	p1=_mm_sub_epi32(_mm_xor_si128(p1,s1),s1);
+#endif
+	/* keep the low 16 bits of each quotient, as the scalar return does */
+	p0=_mm_srai_epi32(_mm_slli_epi32(p0,16),16);
+	p1=_mm_srai_epi32(_mm_slli_epi32(p1,16),16);
+	return _mm_packs_epi32(p0,p1);
+}
+
+static void mul_n_sse2(const qm_n *a, const qm_n *b, qm_n *p, size_t n)
+{
+	size_t i=0;
+
+	for (; i+8<=n; i+=8)
+		_mm_storeu_si128((__m128i *)(p+i),
+			mul8(_mm_loadu_si128((const __m128i *)(a+i)),
+				 _mm_loadu_si128((const __m128i *)(b+i))));
+	mul_n_c(a+i,b+i,p+i,n-i);
+}
+S16_END
+#endif /* S16_SSE2 */
+
+#ifdef S16_AVX2
+S16_BEGIN_AVX2
+/* Sixteen products per call; same steps as mul8(). */
+static __m256i mul16(__m256i a, __m256i b)
+{
+	__m256i lo=_mm256_mullo_epi16(a,b);
+	__m256i hi=_mm256_mulhi_epi16(a,b);
+	__m256i p0=_mm256_unpacklo_epi16(lo,hi);
+	__m256i p1=_mm256_unpackhi_epi16(lo,hi);
+#ifdef USE_BINARY_POINT
+	p0=_mm256_srai_epi32(_mm256_add_epi32(p0,_mm256_set1_epi32(KN)),NSHIFT);
+	p1=_mm256_srai_epi32(_mm256_add_epi32(p1,_mm256_set1_epi32(KN)),NSHIFT);
+#else
+	const __m256i inv=_mm256_set1_epi32(0x51eb851f);
+	__m256i m0=_mm256_add_epi32(_mm256_abs_epi32(p0),_mm256_set1_epi32(KN));
+	__m256i m1=_mm256_add_epi32(_mm256_abs_epi32(p1),_mm256_set1_epi32(KN));
+	__m256i q0e=_mm256_srli_epi64(_mm256_mul_epu32(m0,inv),37);
+	__m256i q0o=_mm256_srli_epi64(
+			_mm256_mul_epu32(_mm256_srli_epi64(m0,32),inv),37);
+	__m256i q1e=_mm256_srli_epi64(_mm256_mul_epu32(m1,inv),37);
+	__m256i q1o=_mm256_srli_epi64(
+			_mm256_mul_epu32(_mm256_srli_epi64(m1,32),inv),37);
+	p0=_mm256_sign_epi32(_mm256_or_si256(q0e,_mm256_slli_epi64(q0o,32)),p0);
+	p1=_mm256_sign_epi32(_mm256_or_si256(q1e,_mm256_slli_epi64(q1o,32)),p1);
+#endif
+	/* unpack/pack both work within 128 bit lanes, so order is preserved */
+	p0=_mm256_srai_epi32(_mm256_slli_epi32(p0,16),16);
+	p1=_mm256_srai_epi32(_mm256_slli_epi32(p1,16),16);
+	return _mm256_packs_epi32(p0,p1);
+}
+
+static void mul_n_avx2(const qm_n *a, const qm_n *b, qm_n *p, size_t n)
+{
+	size_t i=0;
+
+	for (; i+16<=n; i+=16)
+		_mm256_storeu_si256((__m256i *)(p+i),
+			mul16(_mm256_loadu_si256((const __m256i *)(a+i)),
+				  _mm256_loadu_si256((const __m256i *)(b+i))));
+	mul_n_sse2(a+i,b+i,p+i,n-i);
+}
+S16_END
+#endif /* S16_AVX2 */
+
+#ifdef S16_DISPATCH
+static mul_n_fn *resolve_mul_n(void)
+{
+	return S16_KERNEL(mul_n);
+}
+#endif
+
+/** s16_mul_n - multiply arrays
+ * DESCRIPTION
+ *  Computes p[i]=a[i]*b[i] for 0 <= i < n. Each product is rounded exactly
+ *  as s16_mul() rounds it.
+ * PARAMETERS
+ *  a  multiplicands supplied as 16 bit integers having an implied binary
+ *     point with 7 bits of resolution, or an implied decimal point with
+ *     two digits of resolution.
+ *  b  multipliers, same format as a.
+ *  p  receives the n products, same format as a. p may be the same array
+ *     as a or b, but must not otherwise overlap them.
+ *  n  number of elements.
+ * RETURN
+ *  None.
+ * NOTES
+ *  x86 builds pick a scalar, SSE2 or AVX2 kernel for the host when the
+ *  library is loaded; the SSE2 and AVX2 kernels work on 8 or 16 elements
+ *  per step. Overflow is not checked: use s16_mulov() on the elements if
+ *  needed.
+ */
+#ifdef S16_DISPATCH
+void s16_mul_n(const qm_n *a, const qm_n *b, qm_n *p, size_t n)
+	S16_IFUNC(resolve_mul_n);
+#else
+void s16_mul_n(const qm_n *a, const qm_n *b, qm_n *p, size_t n)
+{
+	S16_KERNEL(mul_n)(a,b,p,n);
+
+} /* End s16_mul_n () */
+#endif
@@ -0,0 +1,192 @@
+/* vi:set ts=4: <-- vi tabstop
+   nco.c - numerically controlled oscillator.
+   Copyright (c) 2014 Bryan Batten <bjbatten@acm.org>
+ */
+#include "s16math.h"
+
+/* The oscillator state is kept as Q1.30 cosine and sine. A qm_n result
+   from s16_sincos() has too few bits to seed a recurrence, so anchors and
+   the step rotation come from a 30 stage CORDIC carried out at 32 bits.
+   It folds the angle exactly as s16_sincos() does. */
+#define NCO_SHIFT		30				/* Q1.30 state */
+#define NCO_ONE			((s32)1<<NCO_SHIFT)
+#define NCO_STAGES		30
+#define NCO_LC			((s32)652032874)/* CORDIC_LC in Q1.30 */
+#define NCO_ANCHOR		256				/* default re-anchor interval */
+
+/* atan(2^-i) in Q2.29 */
+static const s32 atantab[NCO_STAGES]={
+	421657428, 248918915, 131521918, 66762579, 33510843, 16771758, 8387925,
+	4194219, 2097141, 1048575, 524288, 262144, 131072, 65536, 32768, 16384,
+	8192, 4096, 2048, 1024, 512, 256, 128, 64, 32, 16, 8, 4, 2, 1
+};
+
+/* qm_rad to Q2.29 radians */
+#ifdef USE_BINARY_POINT
+#define rad2z(phi)		((s32)(phi)<<(29-RSHIFT))
+#else
+#define rad2z(phi)		((s32)(phi)*536871)	/* 2^29/1000 */
+#endif
+
+/* wrap phi into 0 <= phi < S16_RAD */
+static qm_rad wrap(qm_rad phi)
+{
+	phi=s16_unwind(phi);
+	if (isneg(phi))
+		phi+=S16_RAD;
+	return phi;
+
+} /* End wrap () */
+
+/* reduce a step into -S16_PI < step <= S16_PI, keeping its direction */
+static qm_rad signedstep(qm_rad step)
+{
+	step=s16_unwind(step);
+	if (step > S16_PI)
+		step-=S16_RAD;
+	else if (step <= -S16_PI)
+		step+=S16_RAD;
+	return step;
+
+} /* End signedstep () */
+
+/* Q1.30 cosine and sine of -S16_PI < phi < S16_RAD */
+static void cordic32(qm_rad phi, s32 *c, s32 *s)
+{
+	s32 x=NCO_LC,y=0,xn,z;
+	u8 neg=0,i;
+
+	if (phi >= 3*S16_PI/2)
+		phi-=S16_RAD;
+	else if (phi >= S16_PI/2) {
+		neg=1;
+		phi=S16_PI-phi;
+	} else if (phi < -S16_PI/2) {
+		neg=1;
+		phi=-S16_PI-phi;
+	}
+	z=rad2z(phi);
+	for (i=0; i<NCO_STAGES; i++) {
+		if (z >= 0) {
+			xn=x-(y>>i);
+			y+=x>>i;
+			z-=atantab[i];
+		} else {
+			xn=x+(y>>i);
+			y-=x>>i;
+			z+=atantab[i];
+		}
+		x=xn;
+	}
+	*c=neg?-x:x;
+	*s=y;
+
+} /* End cordic32 () */
+
+/* Q1.30 to qm_n, rounded to nearest */
+static qm_n toqmn(s32 v)
+{
+	return (qm_n)(((int64_t)v*UI+(NCO_ONE>>1))>>NCO_SHIFT);
+
+} /* End toqmn () */
+
+/* Q1.30 product */
+#define mul30(a,b)	((s32)(((int64_t)(a)*(b)+(NCO_ONE>>1))>>NCO_SHIFT))
+
+/** s16_nco_init - start an oscillator
+ * DESCRIPTION
+ *  Sets up nco to produce cosine and sine of start, start+step,
+ *  start+2*step and so on.
+ * PARAMETERS
+ *  nco     oscillator state.
+ *  start   phase of the first sample in radians.
+ *  step    phase increment per sample in radians.
+ *  anchor  number of samples between re-anchors, or 0 for the default
+ *          of 256.
+ *  start and step are 16 bit integers having an implied binary point with
+ *  10 bits of resolution, or an implied decimal point with three digits of
+ *  resolution.
+ * RETURN
+ *  None.
+ * NOTES
+ *  The state is held as 32 bit cosine and sine. The first sample and the
+ *  rotation by step come from a 30 stage CORDIC that folds the angle the
+ *  same way s16_sincos() does. step is reduced to -pi < step <= pi, so a
+ *  negative step turns the oscillator clockwise, and a step past pi runs
+ *  as the shorter negative step it aliases to.
+ */
+void s16_nco_init(s16_nco_t *nco, qm_rad start, qm_rad step, u16 anchor)
+{
+	nco->phi=wrap(start);
+	nco->step=signedstep(step);
+	nco->anchor=anchor?anchor:NCO_ANCHOR;
+	nco->n=nco->anchor;
+	cordic32(nco->phi,&nco->cos,&nco->sin);
+	cordic32(nco->step,&nco->dcos,&nco->dsin);
+
+} /* End s16_nco_init () */
+
+/** s16_nco_next - next oscillator sample
+ * DESCRIPTION
+ *  Returns cosine and sine of the current phase, then advances the phase
+ *  by one step. Between anchors each sample costs one complex multiply;
+ *  every anchor samples, and whenever the phase wraps past 0 or S16_RAD
+ *  in either direction, the state is recomputed from the phase by CORDIC,
+ *  which bounds the drift.
+ * PARAMETERS
+ *  nco  oscillator state set up by s16_nco_init().
+ * RETURN
+ *  Cosine and sine packed as s16_sincos() returns them.
+ * NOTES
+ *  The examples/x86 program testnco reports the largest difference between
+ *  the oscillator and s16_sincos() for a given start, step and anchor
+ *  interval. It is one least significant digit in both resolutions.
+ */
+s32 s16_nco_next(s16_nco_t *nco)
+{
+	sincos_t r;
+	s32 c=nco->cos,s=nco->sin;
+
+	r.s.cos=toqmn(c);
+	r.s.sin=toqmn(s);
+	/* S16_RAD is not exactly 2*pi, so also re-anchor where phi wraps,
+	   which a step of either sign does once per cycle */
+	nco->phi+=nco->step;
+	if (--nco->n == 0 || nco->phi >= S16_RAD || isneg(nco->phi)) {
+		if (nco->phi >= S16_RAD)
+			nco->phi-=S16_RAD;
+		else if (isneg(nco->phi))
+			nco->phi+=S16_RAD;
+		nco->n=nco->anchor;
+		cordic32(nco->phi,&nco->cos,&nco->sin);
+	} else {
+		nco->cos=mul30(c,nco->dcos)-mul30(s,nco->dsin);
+		nco->sin=mul30(s,nco->dcos)+mul30(c,nco->dsin);
+	}
+	return r.sincos;
+
+} /* End s16_nco_next () */
+
+/** s16_nco_n - block of oscillator samples
+ * DESCRIPTION
+ *  Stores the next n samples of nco in separate cosine and sine arrays.
+ * PARAMETERS
+ *  nco  oscillator state set up by s16_nco_init().
+ *  cos  receives the n cosines.
+ *  sin  receives the n sines.
+ *  n    number of samples.
+ * RETURN
+ *  None.
+ */
+void s16_nco_n(s16_nco_t *nco, qm_n *cos, qm_n *sin, size_t n)
+{
+	sincos_t r;
+	size_t i;
+
+	for (i=0; i<n; i++) {
+		r.sincos=s16_nco_next(nco);
+		cos[i]=r.s.cos;
+		sin[i]=r.s.sin;
+	}
+
+} /* End s16_nco_n () */
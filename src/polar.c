@@ -0,0 +1,376 @@
+/* vi:set ts=4: <-- vi tabstop
+   polar.c - rectangular to polar coordinates by CORDIC vectoring.
+   Copyright (c) 2014 Bryan Batten <bjbatten@acm.org>
+ */
+#include "cpu.h"		/* for S16_KERNEL () */
+#include "s16math.h"
+
+/* A vector with x < 0 is turned half a circle first, so the vectoring
+   starts within pi/2 of the x axis; (0, 0) has no angle and gives 0. x
+   and y are carried at 32 bits, scaled up by 2^POLAR_SHIFT as in
+   s16_atan_cordic(); the longest vector, 2^15*sqrt(2), times the CORDIC
+   gain stays below 2^31. Rotating onto the x axis leaves x at the
+   magnitude times the gain, which a Q32 reciprocal of the gain for
+   NUM_CORDIC_ENTRIES stages takes out. */
+#define POLAR_SHIFT		14
+#ifdef USE_BINARY_POINT
+#define INVK_Q32		2608131503u		/* 2^32/1.64676025 for 14 stages */
+#else
+#define INVK_Q32		2608131498u		/* 2^32/1.64676026 for 15 stages */
+#endif
+
+typedef void polar_n_fn(const qm_n *iq, qm_n *mag, qm_rad *phi, size_t n);
+
+/* Round a CORDIC angle 0 <= a <= S16_CPI to qm_rad, ties to even as
+   s16_round() does: the parity of the truncated quotient breaks ties. */
+#ifdef USE_BINARY_POINT
+#define rad(a)		(((a)+(1<<(SCALE_CORA-1))-1+(((a)>>SCALE_CORA)&1))	\
+						>>SCALE_CORA)
+#else
+#define rad(a)		(((a)+SCALE_CORA/2-1+(((a)/SCALE_CORA)&1))/SCALE_CORA)
+#endif
+
+/* Turn (*x, y) onto the x axis in n stages. Returns the angle turned
+   through in CORDIC units, and leaves *x at the magnitude times the gain,
+   scaled up by 2^POLAR_SHIFT. */
+static s32 vectoring(s32 *x, s32 y, u8 n)
+{
+	s32 xs=*x,ys=y,xn,d,a=0;
+	u8 i;
+
+	if (isneg(xs)) {
+		a=isneg(ys)?-S16_CPI:S16_CPI;
+		xs=-xs;
+		ys=-ys;
+	}
+	xs<<=POLAR_SHIFT;
+	ys<<=POLAR_SHIFT;
+	/* d is 0 or -1 by the sign of y; (v^d)-d negates v where d is -1 */
+	for (i=0; i<n; i++) {
+		d=ys>>31;
+		xn=xs+(((ys>>i)^d)-d);
+		ys-=((xs>>i)^d)-d;
+		a+=(s16_cordictab[i]^d)-d;
+		xs=xn;
+	}
+	*x=xs;
+	return a;
+}
+
+static s32 polar_c(qm_n x, qm_n y)
+{
+	s32 xs=x,a;
+	u32 m,mh,ml;
+	polar_t r;
+
+	if (!x && !y)
+		return 0;
+	a=vectoring(&xs,y,NUM_CORDIC_ENTRIES);
+	/* floor(x*INVK_Q32/2^32) from 16 bit halves, then round off the scale */
+	mh=(u32)xs>>16;
+	ml=(u32)xs&0xffff;
+	m=mh*(INVK_Q32>>16)+((mh*(INVK_Q32&0xffff)+ml*(INVK_Q32>>16)
+		+((ml*(INVK_Q32&0xffff))>>16))>>16);
+	m=(m+(1<<(POLAR_SHIFT-1)))>>POLAR_SHIFT;
+	r.s.mag=m > S16_MAX?S16_MAX:(qm_n)m;
+	if (a > S16_CPI)
+		a=S16_CPI;
+	r.s.phi=(qm_rad)(isneg(a)?-rad(-a):rad(a));
+	return r.polar;
+}
+
+/* Each array kernel does the elements it can, then hands the rest down. */
+static void polar_n_c(const qm_n *iq, qm_n *mag, qm_rad *phi, size_t n)
+{
+	polar_t r;
+	size_t i;
+
+	for (i=0; i<n; i++) {
+		r.polar=polar_c(iq[2*i],iq[2*i+1]);
+		mag[i]=r.s.mag;
+		phi[i]=r.s.phi;
+	}
+}
+
+#ifdef S16_SSE2
+S16_BEGIN_SSE2
+/* Conditional negate: lanes with m set to all ones are negated. */
+#define neg4(x,m)	_mm_sub_epi32(_mm_xor_si128((x),(m)),(m))
+
+/* high 32 bits of the unsigned product of each lane with INVK_Q32 */
+static __m128i invk4(__m128i x)
+{
+	const __m128i k=_mm_set1_epi32((s32)INVK_Q32);
+	__m128i e=_mm_srli_epi64(_mm_mul_epu32(x,k),32);
+	__m128i o=_mm_mul_epu32(_mm_srli_epi64(x,32),k);
+
+	return _mm_or_si128(e,_mm_and_si128(o,_mm_set_epi32(-1,0,-1,0)));
+}
+
+/* rad() of each lane */
+static __m128i rad4(__m128i a)
+{
+#ifdef USE_BINARY_POINT
+	__m128i q=_mm_and_si128(_mm_srli_epi32(a,SCALE_CORA),_mm_set1_epi32(1));
+
+	a=_mm_add_epi32(a,_mm_set1_epi32((1<<(SCALE_CORA-1))-1));
+	return _mm_srli_epi32(_mm_add_epi32(a,q),SCALE_CORA);
+#else
+	/* a/10 = a*26215/2^18, exact for 0 <= a < 2^15 */
+	const __m128i m=_mm_set1_epi32(26215);
+	__m128i q=_mm_and_si128(_mm_srli_epi32(_mm_madd_epi16(a,m),18),
+							_mm_set1_epi32(1));
+
+	a=_mm_add_epi32(_mm_add_epi32(a,_mm_set1_epi32(SCALE_CORA/2-1)),q);
+	return _mm_srli_epi32(_mm_madd_epi16(a,m),18);
+#endif
+}
+
+/* Four (x,y) pairs, each in one 32 bit lane, to four magnitudes and four
+   angles; same steps as polar_c(). */
+static void polar4(__m128i v, __m128i *mag, __m128i *phi)
+{
+	__m128i x=_mm_srai_epi32(_mm_slli_epi32(v,16),16-POLAR_SHIFT);
+	__m128i y=_mm_slli_epi32(_mm_srai_epi32(v,16),POLAR_SHIFT);
+	__m128i n=_mm_srai_epi32(x,31);
+	__m128i z=_mm_cmpeq_epi32(v,_mm_setzero_si128());
+	__m128i a,m;
+	int i;
+
+	/* half a circle for x < 0: pi, or -pi below the x axis */
+	a=_mm_and_si128(n,neg4(_mm_set1_epi32(S16_CPI),_mm_srai_epi32(y,31)));
+	x=neg4(x,n);
+	y=neg4(y,n);
+	for (i=0; i<NUM_CORDIC_ENTRIES; i++) {
+		__m128i k=_mm_cvtsi32_si128(i);
+		__m128i d=_mm_srai_epi32(y,31);
+		__m128i xs=neg4(_mm_sra_epi32(x,k),d);
+
+		x=_mm_add_epi32(x,neg4(_mm_sra_epi32(y,k),d));
+		y=_mm_sub_epi32(y,xs);
+		a=_mm_add_epi32(a,neg4(_mm_set1_epi32(s16_cordictab[i]),d));
+	}
+	*mag=_mm_srli_epi32(_mm_add_epi32(invk4(x),
+				_mm_set1_epi32(1<<(POLAR_SHIFT-1))),POLAR_SHIFT);
+	m=_mm_cmpgt_epi32(a,_mm_set1_epi32(S16_CPI));
+	a=_mm_or_si128(_mm_andnot_si128(m,a),
+				   _mm_and_si128(m,_mm_set1_epi32(S16_CPI)));
+	n=_mm_srai_epi32(a,31);
+	*phi=_mm_andnot_si128(z,neg4(rad4(neg4(a,n)),n));
+}
+
+/* eight vectors a step; the signed pack saturates magnitudes to S16_MAX */
+static void polar_n_sse2(const qm_n *iq, qm_n *mag, qm_rad *phi, size_t n)
+{
+	size_t i=0;
+
+	for (; i+8<=n; i+=8) {
+		__m128i m0,p0,m1,p1;
+
+		polar4(_mm_loadu_si128((const __m128i *)(iq+2*i)),&m0,&p0);
+		polar4(_mm_loadu_si128((const __m128i *)(iq+2*i+8)),&m1,&p1);
+		_mm_storeu_si128((__m128i *)(mag+i),_mm_packs_epi32(m0,m1));
+		_mm_storeu_si128((__m128i *)(phi+i),_mm_packs_epi32(p0,p1));
+	}
+	polar_n_c(iq+2*i,mag+i,phi+i,n-i);
+}
+S16_END
+#endif /* S16_SSE2 */
+
+#ifdef S16_AVX2
+S16_BEGIN_AVX2
+/* Eight lanes; same steps as the SSE2 helpers above. */
+#define neg8(x,m)	_mm256_sub_epi32(_mm256_xor_si256((x),(m)),(m))
+
+static __m256i invk8(__m256i x)
+{
+	const __m256i k=_mm256_set1_epi32((s32)INVK_Q32);
+	__m256i e=_mm256_srli_epi64(_mm256_mul_epu32(x,k),32);
+	__m256i o=_mm256_mul_epu32(_mm256_srli_epi64(x,32),k);
+
+	return _mm256_blend_epi32(e,o,0xaa);
+}
+
+static __m256i rad8(__m256i a)
+{
+#ifdef USE_BINARY_POINT
+	__m256i q=_mm256_and_si256(_mm256_srli_epi32(a,SCALE_CORA),
+							   _mm256_set1_epi32(1));
+
+	a=_mm256_add_epi32(a,_mm256_set1_epi32((1<<(SCALE_CORA-1))-1));
+	return _mm256_srli_epi32(_mm256_add_epi32(a,q),SCALE_CORA);
+#else
+	const __m256i m=_mm256_set1_epi32(26215);
+	__m256i q=_mm256_and_si256(
+			_mm256_srli_epi32(_mm256_madd_epi16(a,m),18),_mm256_set1_epi32(1));
+
+	a=_mm256_add_epi32(_mm256_add_epi32(a,
+			_mm256_set1_epi32(SCALE_CORA/2-1)),q);
+	return _mm256_srli_epi32(_mm256_madd_epi16(a,m),18);
+#endif
+}
+
+static void polar8(__m256i v, __m256i *mag, __m256i *phi)
+{
+	__m256i x=_mm256_srai_epi32(_mm256_slli_epi32(v,16),16-POLAR_SHIFT);
+	__m256i y=_mm256_slli_epi32(_mm256_srai_epi32(v,16),POLAR_SHIFT);
+	__m256i n=_mm256_srai_epi32(x,31);
+	__m256i z=_mm256_cmpeq_epi32(v,_mm256_setzero_si256());
+	__m256i a;
+	int i;
+
+	a=_mm256_and_si256(n,
+			neg8(_mm256_set1_epi32(S16_CPI),_mm256_srai_epi32(y,31)));
+	x=neg8(x,n);
+	y=neg8(y,n);
+	for (i=0; i<NUM_CORDIC_ENTRIES; i++) {
+		__m128i k=_mm_cvtsi32_si128(i);
+		__m256i d=_mm256_srai_epi32(y,31);
+		__m256i xs=neg8(_mm256_sra_epi32(x,k),d);
+
+		x=_mm256_add_epi32(x,neg8(_mm256_sra_epi32(y,k),d));
+		y=_mm256_sub_epi32(y,xs);
+		a=_mm256_add_epi32(a,neg8(_mm256_set1_epi32(s16_cordictab[i]),d));
+	}
+	*mag=_mm256_srli_epi32(_mm256_add_epi32(invk8(x),
+				_mm256_set1_epi32(1<<(POLAR_SHIFT-1))),POLAR_SHIFT);
+	a=_mm256_min_epi32(a,_mm256_set1_epi32(S16_CPI));
+	*phi=_mm256_andnot_si256(z,
+			_mm256_sign_epi32(rad8(_mm256_abs_epi32(a)),a));
+}
+
+/* sixteen vectors a step; packs works within 128 bit lanes, so the
+   halves are permuted back into order */
+static void polar_n_avx2(const qm_n *iq, qm_n *mag, qm_rad *phi, size_t n)
+{
+	size_t i=0;
+
+	for (; i+16<=n; i+=16) {
+		__m256i m0,p0,m1,p1;
+
+		polar8(_mm256_loadu_si256((const __m256i *)(iq+2*i)),&m0,&p0);
+		polar8(_mm256_loadu_si256((const __m256i *)(iq+2*i+16)),&m1,&p1);
+		_mm256_storeu_si256((__m256i *)(mag+i),_mm256_permute4x64_epi64(
+				_mm256_packs_epi32(m0,m1),_MM_SHUFFLE(3,1,2,0)));
+		_mm256_storeu_si256((__m256i *)(phi+i),_mm256_permute4x64_epi64(
+				_mm256_packs_epi32(p0,p1),_MM_SHUFFLE(3,1,2,0)));
+	}
+	polar_n_sse2(iq+2*i,mag+i,phi+i,n-i);
+}
+S16_END
+#endif /* S16_AVX2 */
+
+#ifdef S16_DISPATCH
+static polar_n_fn *resolve_polar_n(void)
+{
+	return S16_KERNEL(polar_n);
+}
+#endif
+
+/** s16_polar - rectangular to polar coordinates
+ * DESCRIPTION
+ *  Computes the magnitude and the angle of the vector (x, y), as
+ *  s16_hypot(x,y) and s16_atan2(y,x) would, from one CORDIC vectoring
+ *  pass: rotating the vector onto the x axis with the s16_cordictab
+ *  angles sums the angle, and leaves the magnitude times the CORDIC gain
+ *  on the axis.
+ * PARAMETERS
+ *  x  horizontal axis value. Equivalently cosine. I component of I/Q
+ *     data.
+ *  y  vertical axis value. Equivalently sine. Q component of I/Q data.
+ *
+ *  Parameters are supplied as 16 bit integers having implied binary
+ *  points with 7 bits of resolution, or implied decimal points with two
+ *  digits of resolution.
+ * RETURN
+ *  The magnitude in bits 0:15 and the angle in bits 16:31, to be read
+ *  through polar_t as s16_sincos() results are read through sincos_t.
+ *
+ *  The magnitude is in the same format as x, saturating to S16_MAX. The
+ *  angle is in radians, -pi < phi <= pi, represented as a 16 bit integer
+ *  having an implied binary point with 10 bits of resolution, or an
+ *  implied decimal point with three digits of resolution. (0, 0) gives
+ *  0 and 0; y = 0 with x < 0 gives pi.
+ * NOTES
+ *  The magnitude is the exact one rounded to nearest, but may differ
+ *  from s16_hypot() by one near a tie. The angle is within one least
+ *  significant bit of the exact one in every quadrant, where s16_atan2()
+ *  turns toward +- 1.37 radians for tangents beyond +- 3.
+ *
+ *  The stages are branch free, so every vector takes the same time. One
+ *  call takes about a quarter of the time of s16_atan2() and s16_hypot()
+ *  together.
+ */
+s32 s16_polar(qm_n x, qm_n y)
+{
+	return polar_c(x,y);
+
+} /* End s16_polar () */
+
+/** s16_atan2_p - arc tangent of y/x to a given precision
+ * DESCRIPTION
+ *  Computes the angle of the vector (x, y) as s16_polar() does, with the
+ *  vectoring cut to iter stages, for callers that need only a digit or
+ *  two, such as a coarse heading.
+ * PARAMETERS
+ *  y     ordinate, and
+ *  x     abscissa, 16 bit integers having an implied binary point with 7
+ *        bits of resolution, or an implied decimal point with two digits
+ *        of resolution.
+ *  iter  CORDIC stages, 0 through NUM_CORDIC_ENTRIES. Larger values are
+ *        taken as NUM_CORDIC_ENTRIES.
+ * RETURN
+ *  The angle in radians, in the format of s16_atan2() results. (0, 0)
+ *  gives 0. With NUM_CORDIC_ENTRIES stages it is the angle s16_polar()
+ *  returns.
+ * NOTES
+ *  The arguments are in the order of s16_atan2(). The angle left after
+ *  iter stages is about 2^(1-iter) rad at most. No magnitude is taken,
+ *  so a full precision call is a little quicker than s16_polar().
+ */
+qm_rad s16_atan2_p(qm_n y, qm_n x, u8 iter)
+{
+	s32 xs=x,a;
+
+	if (!x && !y)
+		return 0;
+	a=vectoring(&xs,y,iter > NUM_CORDIC_ENTRIES?NUM_CORDIC_ENTRIES:iter);
+	if (a > S16_CPI)
+		a=S16_CPI;
+	return (qm_rad)(isneg(a)?-rad(-a):rad(a));
+
+} /* End s16_atan2_p () */
+
+/** s16_polar_n - polar coordinates of an array of vectors
+ * DESCRIPTION
+ *  Computes mag[i] and phi[i], the s16_polar() results for the vector
+ *  (iq[2*i], iq[2*i+1]), for 0 <= i < n: the magnitude and phase of
+ *  interleaved I/Q samples.
+ * PARAMETERS
+ *  iq   2*n numbers, x then y for each vector, supplied as 16 bit
+ *       integers having an implied binary point with 7 bits of
+ *       resolution, or an implied decimal point with two digits of
+ *       resolution.
+ *  mag  receives the n magnitudes, same format as iq.
+ *  phi  receives the n angles in radians, in the format of s16_atan2()
+ *       results.
+ *  n    number of vectors.
+ *
+ *  mag and phi may not overlap each other or iq.
+ * RETURN
+ *  None.
+ * NOTES
+ *  x86 builds pick a scalar, SSE2 or AVX2 kernel for the host when the
+ *  library is loaded; the SSE2 and AVX2 kernels run the vectoring for 8
+ *  or 16 vectors per step, in 32 bit lanes.
+ */
+#ifdef S16_DISPATCH
+void s16_polar_n(const qm_n *iq, qm_n *mag, qm_rad *phi, size_t n)
+	S16_IFUNC(resolve_polar_n);
+#else
+void s16_polar_n(const qm_n *iq, qm_n *mag, qm_rad *phi, size_t n)
+{
+	S16_KERNEL(polar_n)(iq,mag,phi,n);
+
+} /* End s16_polar_n () */
+#endif
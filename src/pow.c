@@ -0,0 +1,143 @@
+/* vi:set ts=4: <-- vi tabstop
+   pow.c - evaluate powers.
+   Copyright (c) 2014 Bryan Batten <bjbatten@acm.org>
+ */
+#include "s16math.h"
+#include "flt.h"
+
+/* Integer powers are the product of a^(2^i) for the one bits i of the
+   exponent, on the mantissa and exponent numbers of root.c, so an
+   exponent of k takes at most 2*log2(k) products and the power comes out
+   rounded once, to nearest. Squares of |a| >= 1 only grow and squares of
+   |a| < 1 only shrink, so once a square is 2^POW_EMAX or more, or less
+   than 2^(1-POW_EMAX), every qm_n power still to come is S16_MAX or zero,
+   and the loop stops there. */
+#define POW_EMAX		10			/* 2^10 > 327.67, 2^-9 < 0.005 */
+
+/* a^k for any integer k, saturating to +-S16_MAX */
+static qm_n ipow(qm_n a, s16 k)
+{
+	flt_t x,r;
+	u16 n;
+	u8 inv,neg;
+	qm_n y;
+
+	if (!k)
+		return UI;
+	inv=isneg(k);
+	if (!a)
+		return inv?S16_MAX:0;	/* as s16_powexp() */
+	n=(u16)(inv?-(s32)k:k);
+	neg=isneg(a) && (n & 1);
+	x=fromqmn((u32)abs((s32)a));
+	while (!(n & 1)) {
+		x=fmul(x,x);
+		n>>=1;
+		if (abs(x.e) >= POW_EMAX)
+			goto settled;
+	}
+	r=x;
+	while (n >>= 1) {
+		x=fmul(x,x);
+		if (abs(x.e) >= POW_EMAX)
+			goto settled;
+		if (n & 1)
+			r=fmul(r,x);
+	}
+	if (inv)
+		r=fdiv(fnorm(1,30),r);
+	y=toqmn(r);
+	return neg?-y:y;
+
+settled:
+	/* a square too large to invert, or too small to reach S16_MAX */
+	y=isneg(x.e) == inv?S16_MAX:0;
+	return neg?-y:y;
+
+} /* End ipow () */
+
+/** s16_powi - evaluate integer power
+ * DESCRIPTION
+ *  Evaluates a^n for an integer exponent by square and multiply.
+ * PARAMETERS
+ *  a  base, a 16 bit integer having an implied binary point with 7 bits of
+ *     resolution, or an implied decimal point with two digits of
+ *     resolution.
+ *  n  exponent, a plain integer from -128 through 127.
+ * RETURN
+ *  The power rounded to nearest, in the same format as a. Powers too
+ *  large to represent saturate to S16_MAX, or -S16_MAX for a negative
+ *  base and an odd exponent; s16_expov() is true of them.
+ *
+ *  a^0 is 1, 0^0 included. 0 to a negative power saturates to S16_MAX,
+ *  as s16_powexp() does, so s16_expov() is true of it too.
+ * NOTES
+ *  The products are carried on a 32 bit mantissa and an exponent, so
+ *  an exponent of n takes at most 2*log2(|n|) of them and the power is
+ *  rounded once, where a chain of s16_mul() calls rounds each partial
+ *  product and wraps when one overflows. Once a square leaves the range
+ *  of qm_n powers, the result is known and the loop stops. A saturated
+ *  result keeps the sign of the true power, so s16_powov() does not flag
+ *  it. s16_pow() uses this for exponents with no fractional part.
+ */
+qm_n s16_powi(qm_n a, s8 n)
+{
+	return ipow(a,n);
+
+} /* End s16_powi () */
+
+/** s16_pow - evaluate power
+ * DESCRIPTION
+ *  Evaluates a^n and returns the power.
+ *
+ *  An exponent with no fractional part is evaluated as s16_powi() does,
+ *  for any whole exponent the format holds.
+ *
+ *  Otherwise, as for the s16math library version, s16_reduce() takes the
+ *  fractional part f of |n| to x/y, the greatest multiple of 1/4 <= f,
+ *  and the power is the whole part power times (a^(1/y))^x, with both
+ *  exponents negated for a negative n.
+ * PARAMETERS
+ *  Parameters are supplied as 16 bit integers having an implied binary
+ *  point with 7 bits of resolution, or an implied decimal point with two
+ *  digits of resolution.
+ *  a  base to be exponentiated.
+ *  n  exponent.
+ * RETURN
+ *  The power, in the same format as a. Powers too large to represent
+ *  saturate to S16_MAX, or -S16_MAX for a negative power. 0 to a
+ *  negative power returns S16_MAX.
+ *
+ *  A negative base with a fractional exponent whose root s16_root()
+ *  finds imaginary returns 0.
+ * NOTES
+ *  Replaces the s16math library version, which multiplies the whole
+ *  part out with s16_mul(), one call per unit of the exponent, rounding
+ *  and wrapping each partial product. Whole exponents now take at most
+ *  2*log2(n) products, rounded once, and a negative exponent negates the
+ *  integer powers rather than taking the reciprocal of the rounded power
+ *  for -n with s16_div(). The whole part and fractional factors are
+ *  multiplied as s16_mul() does, but saturating. The reference also
+ *  returns 1, or the whole part power alone, where s16_root() returns 0
+ *  for a negative base, and the fractional factor alone where the whole
+ *  part power rounds to 0; and it recurses without end for n of -32768,
+ *  which now returns.
+ */
+qm_n s16_pow(qm_n a, qm_n n)
+{
+	s16 w=n/UI,f=n%UI,k;
+	s32 p;
+
+	if (!f)
+		return ipow(a,w);
+	k=s16_reduce(abs(f));
+	p=ipow(s16_root(a,(k & 0xff)*UI),isneg(f)?-(k>>8):k>>8);
+	if (w) {
+		/* as s16_mul(), but saturating */
+		p=fixscale(nround((s32)ipow(a,w)*p));
+		if (abs(p) > S16_MAX)
+			p=isneg(p)?-S16_MAX:S16_MAX;
+	}
+	return (qm_n)p;
+
+} /* End s16_pow () */
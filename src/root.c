@@ -0,0 +1,171 @@
+/* vi:set ts=4: <-- vi tabstop
+   root.c - evaluate roots by Newton's method.
+   Copyright (c) 2014 Bryan Batten <bjbatten@acm.org>
+ */
+#include "s16math.h"
+#include "flt.h"
+
+/* a^(1/n) is y with y^q = a^p, where p/q is 4/(4*n) in lowest terms.
+   Newton's method for it, y <- y + (a^p/y^(q-1) - y)/q, runs on numbers
+   kept as a 32 bit mantissa and an exponent, so that y^(q-1) neither
+   overflows nor underflows for indices up to 255 (327 decimal). The seed
+   comes from the leading zero count of a, a table of log2(1+j/16) and a
+   table of 2^(j/16); it is close enough for ROOT_STEPS steps to settle
+   for every index. Products keep 28 bits and quotients 20, so the root
+   comes out rounded to nearest. */
+#define ROOT_STEPS		2
+#define TAB_BITS		4				/* log2 of table intervals */
+#ifdef USE_BINARY_POINT
+#define LOG2UI_Q16		((s32)NSHIFT<<16)	/* log2(128) */
+#else
+#define LOG2UI_Q16		((s32)435412)	/* log2(100) */
+#endif
+
+/* log2(1+j/16) in Q16 */
+static const u32 log2tab[(1<<TAB_BITS)+1]={
+	0, 5732, 11136, 16248, 21098, 25711, 30109, 34312, 38336, 42196, 45904,
+	49472, 52911, 56229, 59434, 62534, 65536
+};
+
+/* 2^(j/16) in Q16 */
+static const u32 exp2tab[(1<<TAB_BITS)+1]={
+	65536, 68438, 71468, 74632, 77936, 81386, 84990, 88752, 92682, 96785,
+	101070, 105545, 110218, 115098, 120194, 125515, 131072
+};
+
+/* y + (u - y)/q, the Newton step, for u within a factor of 2 of y */
+static flt_t fstep(flt_t y, flt_t u, u16 q)
+{
+	s32 ym=(s32)(y.m>>1),um;
+	s16 s=u.e-y.e;
+
+	/* both halved, so u aligned to the exponent of y stays below 2^31 */
+	if (s > 0)
+		um=(s32)(u.m&~1u);
+	else um=s < -30?0:(s32)(u.m>>(1-s));
+	return fnorm((u32)(ym+(um-ym)/q),y.e+1);
+}
+
+/* a^n, for 0 < n, as the product of a^(2^i) for the one bits i of n */
+static flt_t fpow(flt_t a, u16 n)
+{
+	flt_t r;
+
+	while (!(n & 1)) {
+		a=fmul(a,a);
+		n>>=1;
+	}
+	r=a;
+	while (n >>= 1) {
+		a=fmul(a,a);
+		if (n & 1)
+			r=fmul(r,a);
+	}
+	return r;
+}
+
+/* 2^t for t in Q16 */
+static flt_t fexp2(s32 t)
+{
+	u32 f=(u32)t&0xffff,j=f>>(16-TAB_BITS),r=f&((1<<(16-TAB_BITS))-1);
+
+	f=exp2tab[j]+(((exp2tab[j+1]-exp2tab[j])*r)>>(16-TAB_BITS));
+	return fnorm(f,(s16)((t>>16)+14));
+}
+
+/* log2(a/UI) in Q16, for 0 < a */
+static s32 flog2(s32 a)
+{
+	u8 k=msb((u32)a);
+	u32 f=((u32)a<<(16-k))&0xffff,j=f>>(16-TAB_BITS);
+
+	f=log2tab[j]+(((log2tab[j+1]-log2tab[j])*(f&((1<<(16-TAB_BITS))-1)))
+		>>(16-TAB_BITS));
+	return ((s32)k<<16)+(s32)f-LOG2UI_Q16;
+}
+
+/** s16_root - evaluate root
+ * DESCRIPTION
+ *  Evaluates a^(1/n) and returns the principal root.
+ *
+ *  As for the s16math library version, fractional indices are taken to
+ *  the greatest multiple of 1/4 <= n, and indices less than 1/4 return
+ *  0. The index then reduces to a power and a root of integer degree,
+ *  a^(1/n) = (a^p)^(1/q), with p one of +-1, +-2 or +-4.
+ * PARAMETERS
+ *  Parameters are supplied as 16 bit integers having an implied binary
+ *  point with 7 bits of resolution, or an implied decimal point with two
+ *  digits of resolution.
+ *  a  number to find root of - i.e. radicand.
+ *  n  degree of root to be found - i.e. index.
+ * RETURN
+ *  The root, in the same format as a. Roots too large to represent
+ *  saturate to S16_MAX, or -S16_MAX for a negative root.
+ *
+ *  A negative radicand with an even q returns zero to indicate overflow
+ *  (the root is imaginary); with an odd q, the root of -a is negated if
+ *  p is odd. 0x8000 is deemed negative and also returns 0, as does a
+ *  zero radicand.
+ * NOTES
+ *  Replaces the s16math library version, which searches for the root
+ *  with trial powers, taking longer the greater the index. This one
+ *  seeds Newton's method from the leading zero count of a and runs
+ *  ROOT_STEPS steps, carrying numbers as a 32 bit mantissa and exponent.
+ *  Results are the root rounded to nearest for every index, where the
+ *  reference is up to 2.5 least significant bits off for indices up to
+ *  16 and tens of them for larger ones. An index of -32768 now returns.
+ *  The mantissa and exponent arithmetic in flt.h is shared with pow.c,
+ *  whose s16_pow() calls this for fractional exponents.
+ */
+qm_n s16_root(qm_n a, qm_n n)
+{
+	flt_t t,y,u;
+	s32 k;
+	s16 p=4;
+	u16 q;
+	u8 neg=0,i;
+
+	/* k = 4*n rounded down, then p/q = 4/k in lowest terms */
+#ifdef USE_BINARY_POINT
+	k=n>>(NSHIFT-2);
+#else
+	k=isneg(n)?(n-(UI/4-1))/(UI/4):n/(UI/4);
+#endif
+	if (!k || !a || a == (qm_n)0x8000)
+		return 0;
+	if (k == 4)
+		return a;
+	if (isneg(k)) {
+		p=-p;
+		k=-k;
+	}
+	while (!(k & 1) && abs(p) > 1) {
+		k>>=1;
+		p/=2;
+	}
+	q=(u16)k;
+	if (isneg(a)) {
+		if (!(q & 1))
+			return 0;
+		neg=p & 1;
+		a=-a;
+	}
+
+	/* a^p, then its qth root */
+	t=fromqmn((u32)a);
+	t=fpow(t,(u16)abs(p));
+	if (isneg(p))
+		t=fdiv(fnorm(1,30),t);
+	if (q == 1)
+		y=t;
+	else {
+		y=fexp2(p*flog2(a)/q);
+		for (i=0; i<ROOT_STEPS; i++) {
+			u=fdiv(t,fpow(y,q-1));
+			y=fstep(y,u,q);
+		}
+	}
+	k=toqmn(y);
+	return neg?-k:k;
+
+} /* End s16_root () */
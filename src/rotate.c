@@ -0,0 +1,436 @@
+/* vi:set ts=4: <-- vi tabstop
+   rotate.c - rotate vectors by CORDIC rotation.
+   Copyright (c) 2014 Bryan Batten <bjbatten@acm.org>
+ */
+#include "cpu.h"		/* for S16_KERNEL () */
+#include "s16math.h"
+
+/* The angle is unwound into -pi..pi, and a half turn taken off by
+   negating x and y, leaving it within pi/2 of 0 for the s16_cordictab
+   micro-rotations. x and y are carried at 32 bits, scaled up by
+   2^ROTATE_SHIFT, as in s16_polar(); at the end a Q32 reciprocal of the
+   gain for NUM_CORDIC_ENTRIES stages takes the CORDIC gain out once. */
+#define ROTATE_SHIFT	14
+#ifdef USE_BINARY_POINT
+#define INVK_Q32		2608131503u		/* 2^32/1.64676025 for 14 stages */
+#else
+#define INVK_Q32		2608131498u		/* 2^32/1.64676026 for 15 stages */
+#endif
+#define HALF_CPI		(S16_CPI/2)
+
+typedef void rotate_n_fn(const qm_n *iq, qm_rad phi, qm_n *r, size_t n);
+typedef void rotate_np_fn(const qm_n *iq, const qm_rad *phi, qm_n *r,
+		size_t n);
+
+/* phi within pi/2 of 0, in CORDIC radians, and *neg set for a half turn.
+   The turns come off after scaling, against 2*S16_CPI, which is much
+   nearer 2*pi than S16_RAD is. */
+static s32 fold(qm_rad phi, u8 *neg)
+{
+	s32 z=scaleup((s32)phi,SCALE_CORA)%(2*S16_CPI);
+
+	if (z > S16_CPI)
+		z-=2*S16_CPI;
+	else if (z < -S16_CPI)
+		z+=2*S16_CPI;
+	*neg=z > HALF_CPI || z < -HALF_CPI;
+	if (z > HALF_CPI)
+		z-=S16_CPI;
+	else if (z < -HALF_CPI)
+		z+=S16_CPI;
+	return z;
+}
+
+/* x*2^ROTATE_SHIFT*gain back to qm_n, rounded half away from zero and
+   saturated to +-S16_MAX */
+static qm_n ungain(s32 x)
+{
+	u32 m=(u32)abs(x),mh=m>>16,ml=m&0xffff;
+
+	/* floor(m*INVK_Q32/2^32) from 16 bit halves */
+	m=mh*(INVK_Q32>>16)+((mh*(INVK_Q32&0xffff)+ml*(INVK_Q32>>16)
+		+((ml*(INVK_Q32&0xffff))>>16))>>16);
+	m=(m+(1<<(ROTATE_SHIFT-1)))>>ROTATE_SHIFT;
+	if (m > S16_MAX)
+		m=S16_MAX;
+	return isneg(x)?-(qm_n)m:(qm_n)m;
+}
+
+/* (x, y) rotated by z CORDIC radians and negated if neg */
+static s32 rotate_c(qm_n x, qm_n y, s32 z, u8 neg)
+{
+	s32 xs=(s32)x<<ROTATE_SHIFT,ys=(s32)y<<ROTATE_SHIFT,xn,d;
+	rect_t r;
+	u8 i;
+
+	if (neg) {
+		xs=-xs;
+		ys=-ys;
+	}
+	/* d is 0 or -1 by the sign of z; (v^d)-d negates v where d is -1 */
+	for (i=0; i<NUM_CORDIC_ENTRIES; i++) {
+		d=z>>31;
+		xn=xs-(((ys>>i)^d)-d);
+		ys+=((xs>>i)^d)-d;
+		z-=(s16_cordictab[i]^d)-d;
+		xs=xn;
+	}
+	r.s.x=ungain(xs);
+	r.s.y=ungain(ys);
+	return r.xy;
+}
+
+/* Each array kernel does the elements it can, then hands the rest down. */
+static void rotate_n_c(const qm_n *iq, qm_rad phi, qm_n *r, size_t n)
+{
+	rect_t v;
+	size_t i;
+	s32 z;
+	u8 neg;
+
+	z=fold(phi,&neg);
+	for (i=0; i<n; i++) {
+		v.xy=rotate_c(iq[2*i],iq[2*i+1],z,neg);
+		r[2*i]=v.s.x;
+		r[2*i+1]=v.s.y;
+	}
+}
+
+static void rotate_np_c(const qm_n *iq, const qm_rad *phi, qm_n *r,
+		size_t n)
+{
+	rect_t v;
+	size_t i;
+	s32 z;
+	u8 neg;
+
+	for (i=0; i<n; i++) {
+		z=fold(phi[i],&neg);
+		v.xy=rotate_c(iq[2*i],iq[2*i+1],z,neg);
+		r[2*i]=v.s.x;
+		r[2*i+1]=v.s.y;
+	}
+}
+
+#ifdef S16_SSE2
+S16_BEGIN_SSE2
+/* Conditional negate: lanes with m set to all ones are negated. */
+#define neg4(x,m)	_mm_sub_epi32(_mm_xor_si128((x),(m)),(m))
+
+/* fold() of each 32 bit lane, the half turns in *neg */
+static __m128i fold4(__m128i p, __m128i *neg)
+{
+	const __m128i pi=_mm_set1_epi32(S16_CPI),hp=_mm_set1_epi32(HALF_CPI);
+	const __m128i tp=_mm_set1_epi32(2*S16_CPI);
+	__m128i s,m;
+	int i;
+
+#ifdef USE_BINARY_POINT
+	p=_mm_slli_epi32(p,SCALE_CORA);
+#else
+	p=_mm_madd_epi16(p,_mm_set1_epi32(SCALE_CORA));
+#endif
+	/* |z| % (2*S16_CPI) by taking off 4, 2, 1 turns, then the sign back,
+	   as % does */
+	s=_mm_srai_epi32(p,31);
+	p=neg4(p,s);
+	for (i=2; i>=0; i--) {
+		__m128i r=_mm_set1_epi32((2*S16_CPI)<<i);
+		p=_mm_sub_epi32(p,_mm_andnot_si128(_mm_cmpgt_epi32(r,p),r));
+	}
+	p=neg4(p,s);
+	m=_mm_cmpgt_epi32(p,pi);
+	p=_mm_sub_epi32(p,_mm_and_si128(m,tp));
+	m=_mm_cmpgt_epi32(_mm_set1_epi32(-S16_CPI),p);
+	p=_mm_add_epi32(p,_mm_and_si128(m,tp));
+	m=_mm_cmpgt_epi32(p,hp);
+	s=_mm_cmpgt_epi32(_mm_set1_epi32(-HALF_CPI),p);
+	*neg=_mm_or_si128(m,s);
+	p=_mm_sub_epi32(p,_mm_and_si128(m,pi));
+	return _mm_add_epi32(p,_mm_and_si128(s,pi));
+}
+
+/* ungain() of each lane */
+static __m128i ungain4(__m128i x)
+{
+	const __m128i k=_mm_set1_epi32((s32)INVK_Q32);
+	const __m128i c=_mm_set1_epi32(S16_MAX);
+	__m128i s=_mm_srai_epi32(x,31),m=neg4(x,s),e,o;
+
+	e=_mm_srli_epi64(_mm_mul_epu32(m,k),32);
+	o=_mm_mul_epu32(_mm_srli_epi64(m,32),k);
+	m=_mm_or_si128(e,_mm_and_si128(o,_mm_set_epi32(-1,0,-1,0)));
+	m=_mm_srli_epi32(_mm_add_epi32(m,_mm_set1_epi32(1<<(ROTATE_SHIFT-1))),
+					 ROTATE_SHIFT);
+	e=_mm_cmpgt_epi32(m,c);
+	m=_mm_or_si128(_mm_andnot_si128(e,m),_mm_and_si128(e,c));
+	return neg4(m,s);
+}
+
+/* Four (x,y) pairs, each in one 32 bit lane, rotated by z and negated in
+   the lanes of neg; same steps as rotate_c(). */
+static __m128i rotate4(__m128i v, __m128i z, __m128i neg)
+{
+	__m128i x=_mm_srai_epi32(_mm_slli_epi32(v,16),16-ROTATE_SHIFT);
+	__m128i y=_mm_slli_epi32(_mm_srai_epi32(v,16),ROTATE_SHIFT);
+	int i;
+
+	x=neg4(x,neg);
+	y=neg4(y,neg);
+	for (i=0; i<NUM_CORDIC_ENTRIES; i++) {
+		__m128i k=_mm_cvtsi32_si128(i);
+		__m128i d=_mm_srai_epi32(z,31);
+		__m128i xs=neg4(_mm_sra_epi32(x,k),d);
+
+		x=_mm_sub_epi32(x,neg4(_mm_sra_epi32(y,k),d));
+		y=_mm_add_epi32(y,xs);
+		z=_mm_sub_epi32(z,neg4(_mm_set1_epi32(s16_cordictab[i]),d));
+	}
+	return _mm_or_si128(_mm_and_si128(ungain4(x),_mm_set1_epi32(0xffff)),
+						_mm_slli_epi32(ungain4(y),16));
+}
+
+static void rotate_n_sse2(const qm_n *iq, qm_rad phi, qm_n *r, size_t n)
+{
+	__m128i z,neg;
+	size_t i=0;
+
+	z=fold4(_mm_set1_epi32(phi),&neg);
+	for (; i+4<=n; i+=4)
+		_mm_storeu_si128((__m128i *)(r+2*i),
+			rotate4(_mm_loadu_si128((const __m128i *)(iq+2*i)),z,neg));
+	rotate_n_c(iq+2*i,phi,r+2*i,n-i);
+}
+
+static void rotate_np_sse2(const qm_n *iq, const qm_rad *phi, qm_n *r,
+		size_t n)
+{
+	__m128i p,z,neg;
+	size_t i=0;
+
+	for (; i+4<=n; i+=4) {
+		/* four angles, sign extended into 32 bit lanes */
+		p=_mm_loadl_epi64((const __m128i *)(phi+i));
+		z=fold4(_mm_srai_epi32(_mm_unpacklo_epi16(p,p),16),&neg);
+		_mm_storeu_si128((__m128i *)(r+2*i),
+			rotate4(_mm_loadu_si128((const __m128i *)(iq+2*i)),z,neg));
+	}
+	rotate_np_c(iq+2*i,phi+i,r+2*i,n-i);
+}
+S16_END
+#endif /* S16_SSE2 */
+
+#ifdef S16_AVX2
+S16_BEGIN_AVX2
+/* Eight lanes; same steps as the SSE2 helpers above. */
+#define neg8(x,m)	_mm256_sub_epi32(_mm256_xor_si256((x),(m)),(m))
+
+static __m256i fold8(__m256i p, __m256i *neg)
+{
+	const __m256i pi=_mm256_set1_epi32(S16_CPI);
+	const __m256i hp=_mm256_set1_epi32(HALF_CPI);
+	const __m256i tp=_mm256_set1_epi32(2*S16_CPI);
+	__m256i a,m,s;
+	int i;
+
+#ifdef USE_BINARY_POINT
+	p=_mm256_slli_epi32(p,SCALE_CORA);
+#else
+	p=_mm256_mullo_epi32(p,_mm256_set1_epi32(SCALE_CORA));
+#endif
+	a=_mm256_abs_epi32(p);
+	for (i=2; i>=0; i--) {
+		__m256i r=_mm256_set1_epi32((2*S16_CPI)<<i);
+		a=_mm256_sub_epi32(a,_mm256_andnot_si256(_mm256_cmpgt_epi32(r,a),r));
+	}
+	p=_mm256_sign_epi32(a,p);
+	m=_mm256_cmpgt_epi32(p,pi);
+	p=_mm256_sub_epi32(p,_mm256_and_si256(m,tp));
+	m=_mm256_cmpgt_epi32(_mm256_set1_epi32(-S16_CPI),p);
+	p=_mm256_add_epi32(p,_mm256_and_si256(m,tp));
+	m=_mm256_cmpgt_epi32(p,hp);
+	s=_mm256_cmpgt_epi32(_mm256_set1_epi32(-HALF_CPI),p);
+	*neg=_mm256_or_si256(m,s);
+	p=_mm256_sub_epi32(p,_mm256_and_si256(m,pi));
+	return _mm256_add_epi32(p,_mm256_and_si256(s,pi));
+}
+
+static __m256i ungain8(__m256i x)
+{
+	const __m256i k=_mm256_set1_epi32((s32)INVK_Q32);
+	__m256i m=_mm256_abs_epi32(x),e,o;
+
+	e=_mm256_srli_epi64(_mm256_mul_epu32(m,k),32);
+	o=_mm256_mul_epu32(_mm256_srli_epi64(m,32),k);
+	m=_mm256_blend_epi32(e,o,0xaa);
+	m=_mm256_srli_epi32(_mm256_add_epi32(m,
+			_mm256_set1_epi32(1<<(ROTATE_SHIFT-1))),ROTATE_SHIFT);
+	return _mm256_sign_epi32(_mm256_min_epi32(m,_mm256_set1_epi32(S16_MAX)),
+							 x);
+}
+
+static __m256i rotate8(__m256i v, __m256i z, __m256i neg)
+{
+	__m256i x=_mm256_srai_epi32(_mm256_slli_epi32(v,16),16-ROTATE_SHIFT);
+	__m256i y=_mm256_slli_epi32(_mm256_srai_epi32(v,16),ROTATE_SHIFT);
+	int i;
+
+	x=neg8(x,neg);
+	y=neg8(y,neg);
+	for (i=0; i<NUM_CORDIC_ENTRIES; i++) {
+		__m128i k=_mm_cvtsi32_si128(i);
+		__m256i d=_mm256_srai_epi32(z,31);
+		__m256i xs=neg8(_mm256_sra_epi32(x,k),d);
+
+		x=_mm256_sub_epi32(x,neg8(_mm256_sra_epi32(y,k),d));
+		y=_mm256_add_epi32(y,xs);
+		z=_mm256_sub_epi32(z,neg8(_mm256_set1_epi32(s16_cordictab[i]),d));
+	}
+	return _mm256_blend_epi16(ungain8(x),_mm256_slli_epi32(ungain8(y),16),
+							  0xaa);
+}
+
+static void rotate_n_avx2(const qm_n *iq, qm_rad phi, qm_n *r, size_t n)
+{
+	__m256i z,neg;
+	size_t i=0;
+
+	z=fold8(_mm256_set1_epi32(phi),&neg);
+	for (; i+8<=n; i+=8)
+		_mm256_storeu_si256((__m256i *)(r+2*i),
+			rotate8(_mm256_loadu_si256((const __m256i *)(iq+2*i)),z,neg));
+	rotate_n_sse2(iq+2*i,phi,r+2*i,n-i);
+}
+
+static void rotate_np_avx2(const qm_n *iq, const qm_rad *phi, qm_n *r,
+		size_t n)
+{
+	__m256i z,neg;
+	size_t i=0;
+
+	for (; i+8<=n; i+=8) {
+		z=fold8(_mm256_cvtepi16_epi32(
+				_mm_loadu_si128((const __m128i *)(phi+i))),&neg);
+		_mm256_storeu_si256((__m256i *)(r+2*i),
+			rotate8(_mm256_loadu_si256((const __m256i *)(iq+2*i)),z,neg));
+	}
+	rotate_np_sse2(iq+2*i,phi+i,r+2*i,n-i);
+}
+S16_END
+#endif /* S16_AVX2 */
+
+#ifdef S16_DISPATCH
+static rotate_n_fn *resolve_rotate_n(void)
+{
+	return S16_KERNEL(rotate_n);
+}
+
+static rotate_np_fn *resolve_rotate_np(void)
+{
+	return S16_KERNEL(rotate_np);
+}
+#endif
+
+/** s16_rotate - rotate a vector
+ * DESCRIPTION
+ *  Rotates the vector (x, y) through the angle phi by CORDIC rotation:
+ *  the s16_cordictab micro-rotations are applied to x and y themselves,
+ *  with no sine or cosine formed, and the CORDIC gain is taken out once
+ *  at the end.
+ * PARAMETERS
+ *  x    horizontal axis value. Equivalently cosine. I component of I/Q
+ *       data.
+ *  y    vertical axis value. Equivalently sine. Q component of I/Q data.
+ *
+ *  x and y are supplied as 16 bit integers having implied binary points
+ *  with 7 bits of resolution, or implied decimal points with two digits
+ *  of resolution.
+ *  phi  angle in radians, positive counterclockwise, as for s16_sincos().
+ * RETURN
+ *  The rotated x in bits 0:15 and y in bits 16:31, to be read through
+ *  rect_t as s16_sincos() results are read through sincos_t. Each is in
+ *  the format of x and y, rounded to nearest and saturated to +-S16_MAX.
+ * NOTES
+ *  In place of s16_sincos() and four s16_mul() calls, which round cos
+ *  and sin to qm_n before they multiply. Here x and y are carried at 32
+ *  bits through NUM_CORDIC_ENTRIES add and shift stages, and are rounded
+ *  once. Whole turns come off phi against 2*S16_CPI rather than
+ *  S16_RAD, so large angles do not drift. Results are within 1/2 least
+ *  significant bit, plus 2^-12 (binary) or 5*10^-4 (decimal) of the
+ *  length of the vector for the resolution of the s16_cordictab angles,
+ *  of the exact rotation.
+ */
+s32 s16_rotate(qm_n x, qm_n y, qm_rad phi)
+{
+	s32 z;
+	u8 neg;
+
+	z=fold(phi,&neg);
+	return rotate_c(x,y,z,neg);
+
+} /* End s16_rotate () */
+
+/** s16_rotate_n - rotate an array of vectors through one angle
+ * DESCRIPTION
+ *  Rotates each vector (iq[2*i], iq[2*i+1]), 0 <= i < n, through the
+ *  angle phi, with the results of s16_rotate(): mixing interleaved I/Q
+ *  samples by a fixed phase, for example.
+ * PARAMETERS
+ *  iq   2*n numbers, x then y for each vector, supplied as 16 bit
+ *       integers having an implied binary point with 7 bits of
+ *       resolution, or an implied decimal point with two digits of
+ *       resolution.
+ *  phi  angle in radians.
+ *  r    receives the 2*n rotated numbers, interleaved as iq and in the
+ *       same format. r may be the same array as iq, but must not
+ *       otherwise overlap it.
+ *  n    number of vectors.
+ * RETURN
+ *  None.
+ * NOTES
+ *  The angle is unwound once for the whole array. x86 builds pick a
+ *  scalar, SSE2 or AVX2 kernel for the host when the library is loaded;
+ *  the SSE2 and AVX2 kernels rotate 4 or 8 vectors per step.
+ */
+#ifdef S16_DISPATCH
+void s16_rotate_n(const qm_n *iq, qm_rad phi, qm_n *r, size_t n)
+	S16_IFUNC(resolve_rotate_n);
+#else
+void s16_rotate_n(const qm_n *iq, qm_rad phi, qm_n *r, size_t n)
+{
+	S16_KERNEL(rotate_n)(iq,phi,r,n);
+
+} /* End s16_rotate_n () */
+#endif
+
+/** s16_rotate_np - rotate an array of vectors through an array of angles
+ * DESCRIPTION
+ *  Rotates each vector (iq[2*i], iq[2*i+1]) through its own angle
+ *  phi[i], 0 <= i < n, with the results of s16_rotate().
+ * PARAMETERS
+ *  iq   2*n numbers, x then y for each vector, supplied as 16 bit
+ *       integers having an implied binary point with 7 bits of
+ *       resolution, or an implied decimal point with two digits of
+ *       resolution.
+ *  phi  n angles in radians.
+ *  r    receives the 2*n rotated numbers, interleaved as iq and in the
+ *       same format. r may be the same array as iq, but must not
+ *       otherwise overlap it or phi.
+ *  n    number of vectors.
+ * RETURN
+ *  None.
+ * NOTES
+ *  x86 builds pick a scalar, SSE2 or AVX2 kernel for the host when the
+ *  library is loaded; the SSE2 and AVX2 kernels rotate 4 or 8 vectors per
+ *  step.
+ */
+#ifdef S16_DISPATCH
+void s16_rotate_np(const qm_n *iq, const qm_rad *phi, qm_n *r, size_t n)
+	S16_IFUNC(resolve_rotate_np);
+#else
+void s16_rotate_np(const qm_n *iq, const qm_rad *phi, qm_n *r, size_t n)
+{
+	S16_KERNEL(rotate_np)(iq,phi,r,n);
+
+} /* End s16_rotate_np () */
+#endif
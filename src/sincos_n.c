@@ -0,0 +1,445 @@
+/* vi:set ts=4: <-- vi tabstop
+   sincos_n.c - sine and cosine of an angle or of arrays of angles.
+   Copyright (c) 2014 Bryan Batten <bjbatten@acm.org>
+ */
+#include "cpu.h"		/* for S16_KERNEL () */
+#include "s16math.h"
+
+/* Every kernel follows the steps of the reference s16_sincos() exactly:
+   unwind phi, fold it into -pi/2 <= phi < pi/2, run the CORDIC rotation
+   in 16 bit arithmetic, then round the Q2.13 (Q1.4) results to qm_n with
+   two s16_round() steps. */
+
+#define HALF_PI		(S16_PI/2)
+#define THREE_HALF_PI	(3*S16_PI/2)
+
+/* CORDIC_LC, the inverse CORDIC gain, for 0 through 6 stages, rounded
+   down as it is; from 7 stages on it is CORDIC_LC itself. */
+#ifdef USE_BINARY_POINT
+static const qm_cora cordic_lc[]={
+	8192, 5792, 5181, 5026, 4987, 4977, 4975
+};
+#else
+static const qm_cora cordic_lc[]={
+	10000, 7071, 6324, 6135, 6088, 6076, 6073
+};
+#endif
+
+typedef s32 sincos_fn(qm_rad phi);
+typedef void sincos_n_fn(const qm_rad *phi, qm_n *cos, qm_n *sin, size_t n);
+
+/* Scale a CORDIC result down to qm_n, rounding at each step. */
+static qm_n nearestnth(s16 x)
+{
+	u8 neg=isneg(x),i;
+
+	if (neg)
+		x=-x;
+	for (i=0; i<2; i++)
+#ifdef USE_BINARY_POINT
+		x=s16_round(x)>>FSHIFT;
+#else
+		x=s16_round(x)/FSCALE;
+#endif
+	return neg?-x:x;
+}
+
+/* the reference steps, with the rotation cut to n stages from a start
+   of lc on the x axis */
+static s32 sincos_stages(qm_rad phi, u8 n, qm_cora lc)
+{
+	s16 x=lc,y=0,xn,d;
+	u8 neg=0,i;
+	sincos_t r;
+
+	phi%=S16_RAD;
+	if (phi >= THREE_HALF_PI)
+		phi-=S16_RAD;
+	else if (phi >= HALF_PI) {
+		neg=1;
+		phi=S16_PI-phi;
+	}
+	phi=scaleup(phi,SCALE_CORA);
+	/* d is 0 or -1 by the sign of phi; (v^d)-d negates v where d is -1 */
+	for (i=0; i<n; i++) {
+		d=phi>>15;
+		xn=x-(((y>>i)^d)-d);
+		y+=((x>>i)^d)-d;
+		phi-=(s16_cordictab[i]^d)-d;
+		x=xn;
+	}
+	r.s.cos=nearestnth(neg?-x:x);
+	r.s.sin=nearestnth(y);
+	return r.sincos;
+}
+
+static s32 sincos_c(qm_rad phi)
+{
+	return sincos_stages(phi,NUM_CORDIC_ENTRIES,CORDIC_LC);
+}
+
+static void sincos_n_c(const qm_rad *phi, qm_n *cos, qm_n *sin, size_t n)
+{
+	sincos_t r;
+	size_t i;
+
+	for (i=0; i<n; i++) {
+		r.sincos=sincos_c(phi[i]);
+		cos[i]=r.s.cos;
+		sin[i]=r.s.sin;
+	}
+}
+
+#ifdef S16_SSE2
+S16_BEGIN_SSE2
+/* Conditional negate: lanes with m set to all ones are negated. */
+#define neg8(x,m)	_mm_sub_epi16(_mm_xor_si128((x),(m)),(m))
+
+#ifndef USE_BINARY_POINT
+/* x/10 truncated toward zero; 26215/2^18 is exact over the s16 range. */
+static __m128i div10_8(__m128i x)
+{
+	__m128i q=_mm_srai_epi16(_mm_mulhi_epi16(x,_mm_set1_epi16(26215)),2);
+	return _mm_sub_epi16(q,_mm_srai_epi16(x,15));
+}
+#endif
+
+/* unsigned 16 bit x >= c for each lane */
+#define uge8(x,c)	_mm_cmpeq_epi16(_mm_subs_epu16((c),(x)),_mm_setzero_si128())
+
+/* s16_round() for each lane */
+static __m128i round8(__m128i x)
+{
+	const __m128i fs=_mm_set1_epi16(FSCALE);
+	__m128i n=_mm_srai_epi16(x,15);
+	__m128i d,up;
+
+	x=neg8(x,n);
+#ifdef USE_BINARY_POINT
+	d=_mm_and_si128(x,_mm_set1_epi16(FMASK));
+	x=_mm_sub_epi16(x,d);
+	up=_mm_cmpeq_epi16(_mm_and_si128(x,fs),fs);
+#else
+	d=_mm_sub_epi16(x,_mm_mullo_epi16(div10_8(x),fs));
+	d=neg8(d,_mm_srai_epi16(d,15));
+	x=_mm_sub_epi16(x,d);
+	up=_mm_cmpeq_epi16(_mm_and_si128(div10_8(x),_mm_set1_epi16(1)),
+					   _mm_set1_epi16(1));
+#endif
+	up=_mm_and_si128(up,_mm_cmpeq_epi16(d,_mm_set1_epi16(FSCALE/2)));
+	up=_mm_or_si128(up,_mm_cmpgt_epi16(d,_mm_set1_epi16(FSCALE/2)));
+	x=_mm_add_epi16(x,_mm_and_si128(up,fs));
+	x=_mm_sub_epi16(x,_mm_and_si128(_mm_srai_epi16(x,15),fs));
+	return neg8(x,n);
+}
+
+/* Scale a CORDIC result down to qm_n, rounding at each step. */
+static __m128i nearestnth8(__m128i x)
+{
+	__m128i n=_mm_srai_epi16(x,15);
+	int i;
+
+	x=neg8(x,n);
+	for (i=0; i<2; i++) {
+		x=round8(x);
+#ifdef USE_BINARY_POINT
+		x=_mm_srai_epi16(x,FSHIFT);
+#else
+		x=div10_8(x);
+#endif
+	}
+	return neg8(x,n);
+}
+
+static void sincos8(__m128i phi, __m128i *c, __m128i *s)
+{
+	__m128i n=_mm_srai_epi16(phi,15);
+	__m128i x=_mm_set1_epi16(CORDIC_LC);
+	__m128i y=_mm_setzero_si128();
+	__m128i m,neg;
+	int i;
+
+	/* s16_unwind(): |phi| % S16_RAD by subtracting 4, 2, 1 times S16_RAD,
+	   which covers every quotient of a 16 bit magnitude */
+	phi=neg8(phi,n);
+	for (i=2; i>=0; i--) {
+		__m128i r=_mm_set1_epi16((s16)(S16_RAD<<i));
+		phi=_mm_sub_epi16(phi,_mm_and_si128(uge8(phi,r),r));
+	}
+	phi=neg8(phi,n);
+
+	/* fold into the CORDIC convergence range */
+	m=_mm_cmpgt_epi16(phi,_mm_set1_epi16(THREE_HALF_PI-1));
+	phi=_mm_sub_epi16(phi,_mm_and_si128(m,_mm_set1_epi16(S16_RAD)));
+	neg=_mm_andnot_si128(m,_mm_cmpgt_epi16(phi,_mm_set1_epi16(HALF_PI-1)));
+	phi=_mm_or_si128(_mm_andnot_si128(neg,phi),
+			_mm_and_si128(neg,_mm_sub_epi16(_mm_set1_epi16(S16_PI),phi)));
+#ifdef USE_BINARY_POINT
+	phi=_mm_slli_epi16(phi,SCALE_CORA);
+#else
+	phi=_mm_mullo_epi16(phi,_mm_set1_epi16(SCALE_CORA));
+#endif
+
+	for (i=0; i<NUM_CORDIC_ENTRIES; i++) {
+		__m128i k=_mm_cvtsi32_si128(i);
+		__m128i d=_mm_srai_epi16(phi,15);
+		__m128i xs=neg8(_mm_sra_epi16(x,k),d);
+		__m128i ys=neg8(_mm_sra_epi16(y,k),d);
+
+		phi=_mm_sub_epi16(phi,neg8(_mm_set1_epi16(s16_cordictab[i]),d));
+		x=_mm_sub_epi16(x,ys);
+		y=_mm_add_epi16(y,xs);
+	}
+	*c=nearestnth8(neg8(x,neg));
+	*s=nearestnth8(y);
+}
+
+/* one angle in lane 0: no branches to mispredict */
+static s32 sincos_sse2(qm_rad phi)
+{
+	__m128i c,s;
+	sincos_t r;
+
+	sincos8(_mm_cvtsi32_si128((u16)phi),&c,&s);
+	r.s.cos=(qm_n)_mm_cvtsi128_si32(c);
+	r.s.sin=(qm_n)_mm_cvtsi128_si32(s);
+	return r.sincos;
+}
+
+static void sincos_n_sse2(const qm_rad *phi, qm_n *cos, qm_n *sin, size_t n)
+{
+	size_t i=0;
+
+	for (; i+8<=n; i+=8) {
+		__m128i c,s;
+
+		sincos8(_mm_loadu_si128((const __m128i *)(phi+i)),&c,&s);
+		_mm_storeu_si128((__m128i *)(cos+i),c);
+		_mm_storeu_si128((__m128i *)(sin+i),s);
+	}
+	sincos_n_c(phi+i,cos+i,sin+i,n-i);
+}
+S16_END
+#endif /* S16_SSE2 */
+
+#ifdef S16_AVX2
+S16_BEGIN_AVX2
+/* Sixteen lanes; same steps as the SSE2 helpers above. */
+#define neg16(x,m)	_mm256_sub_epi16(_mm256_xor_si256((x),(m)),(m))
+
+#ifndef USE_BINARY_POINT
+static __m256i div10_16(__m256i x)
+{
+	__m256i q=_mm256_srai_epi16(
+			_mm256_mulhi_epi16(x,_mm256_set1_epi16(26215)),2);
+	return _mm256_sub_epi16(q,_mm256_srai_epi16(x,15));
+}
+#endif
+
+#define uge16(x,c)	_mm256_cmpeq_epi16(_mm256_max_epu16((x),(c)),(x))
+
+static __m256i round16(__m256i x)
+{
+	const __m256i fs=_mm256_set1_epi16(FSCALE);
+	__m256i n=_mm256_srai_epi16(x,15);
+	__m256i d,up;
+
+	x=neg16(x,n);
+#ifdef USE_BINARY_POINT
+	d=_mm256_and_si256(x,_mm256_set1_epi16(FMASK));
+	x=_mm256_sub_epi16(x,d);
+	up=_mm256_cmpeq_epi16(_mm256_and_si256(x,fs),fs);
+#else
+	d=_mm256_abs_epi16(_mm256_sub_epi16(x,_mm256_mullo_epi16(div10_16(x),fs)));
+	x=_mm256_sub_epi16(x,d);
+	up=_mm256_cmpeq_epi16(_mm256_and_si256(div10_16(x),_mm256_set1_epi16(1)),
+						  _mm256_set1_epi16(1));
+#endif
+	up=_mm256_and_si256(up,_mm256_cmpeq_epi16(d,_mm256_set1_epi16(FSCALE/2)));
+	up=_mm256_or_si256(up,_mm256_cmpgt_epi16(d,_mm256_set1_epi16(FSCALE/2)));
+	x=_mm256_add_epi16(x,_mm256_and_si256(up,fs));
+	x=_mm256_sub_epi16(x,_mm256_and_si256(_mm256_srai_epi16(x,15),fs));
+	return neg16(x,n);
+}
+
+static __m256i nearestnth16(__m256i x)
+{
+	__m256i n=_mm256_srai_epi16(x,15);
+	int i;
+
+	x=neg16(x,n);
+	for (i=0; i<2; i++) {
+		x=round16(x);
+#ifdef USE_BINARY_POINT
+		x=_mm256_srai_epi16(x,FSHIFT);
+#else
+		x=div10_16(x);
+#endif
+	}
+	return neg16(x,n);
+}
+
+static void sincos16(__m256i phi, __m256i *c, __m256i *s)
+{
+	__m256i n=_mm256_srai_epi16(phi,15);
+	__m256i x=_mm256_set1_epi16(CORDIC_LC);
+	__m256i y=_mm256_setzero_si256();
+	__m256i m,neg;
+	int i;
+
+	phi=neg16(phi,n);
+	for (i=2; i>=0; i--) {
+		__m256i r=_mm256_set1_epi16((s16)(S16_RAD<<i));
+		phi=_mm256_sub_epi16(phi,_mm256_and_si256(uge16(phi,r),r));
+	}
+	phi=neg16(phi,n);
+
+	m=_mm256_cmpgt_epi16(phi,_mm256_set1_epi16(THREE_HALF_PI-1));
+	phi=_mm256_sub_epi16(phi,_mm256_and_si256(m,_mm256_set1_epi16(S16_RAD)));
+	neg=_mm256_andnot_si256(m,
+			_mm256_cmpgt_epi16(phi,_mm256_set1_epi16(HALF_PI-1)));
+	phi=_mm256_blendv_epi8(phi,
+			_mm256_sub_epi16(_mm256_set1_epi16(S16_PI),phi),neg);
+#ifdef USE_BINARY_POINT
+	phi=_mm256_slli_epi16(phi,SCALE_CORA);
+#else
+	phi=_mm256_mullo_epi16(phi,_mm256_set1_epi16(SCALE_CORA));
+#endif
+
+	for (i=0; i<NUM_CORDIC_ENTRIES; i++) {
+		__m128i k=_mm_cvtsi32_si128(i);
+		__m256i d=_mm256_srai_epi16(phi,15);
+		__m256i xs=neg16(_mm256_sra_epi16(x,k),d);
+		__m256i ys=neg16(_mm256_sra_epi16(y,k),d);
+
+		phi=_mm256_sub_epi16(phi,
+				neg16(_mm256_set1_epi16(s16_cordictab[i]),d));
+		x=_mm256_sub_epi16(x,ys);
+		y=_mm256_add_epi16(y,xs);
+	}
+	*c=nearestnth16(neg16(x,neg));
+	*s=nearestnth16(y);
+}
+
+static void sincos_n_avx2(const qm_rad *phi, qm_n *cos, qm_n *sin, size_t n)
+{
+	size_t i=0;
+
+	for (; i+16<=n; i+=16) {
+		__m256i c,s;
+
+		sincos16(_mm256_loadu_si256((const __m256i *)(phi+i)),&c,&s);
+		_mm256_storeu_si256((__m256i *)(cos+i),c);
+		_mm256_storeu_si256((__m256i *)(sin+i),s);
+	}
+	sincos_n_sse2(phi+i,cos+i,sin+i,n-i);
+}
+S16_END
+#endif /* S16_AVX2 */
+
+#ifdef S16_DISPATCH
+static sincos_fn *resolve_sincos(void)
+{
+	return S16_KERNEL_SSE2(sincos);
+}
+
+static sincos_n_fn *resolve_sincos_n(void)
+{
+	return S16_KERNEL(sincos_n);
+}
+#endif
+
+/** s16_sincos - sine and cosine
+ * DESCRIPTION
+ *  Computes sine and cosine of angle z. z is unwound as needed to fall in
+ *  the range -pi/2 <= z <= pi/2.
+ * PARAMETER
+ *  z  numeric argument is an angle in radians supplied as a 16 bit integer
+ *     having an implied binary point with 10 bits of resolution, or an
+ *     implied decimal point with three digits of resolution.
+ * RETURN
+ *  Sine and cosine are returned in a structure with two 16 bit signed
+ *  integers in a 32 bit union containing a structure with two 16 bit
+ *  members. Cosine is returned in the cos member. Sine is returned in the
+ *  sin member. sin, cos range from -1.00 through 1.00 inclusive.
+ * NOTES
+ *  Replaces the s16math library version with the same results. x86 builds
+ *  pick a scalar or SSE2 kernel for the host when the library is loaded;
+ *  neither branches on the CORDIC direction.
+ */
+#ifdef S16_DISPATCH
+s32 s16_sincos(qm_rad z) S16_IFUNC(resolve_sincos);
+#else
+s32 s16_sincos(qm_rad z)
+{
+	return S16_KERNEL_SSE2(sincos)(z);
+
+} /* End s16_sincos () */
+#endif
+
+/** s16_sincos_p - sine and cosine to a given precision
+ * DESCRIPTION
+ *  Computes sine and cosine of angle z as s16_sincos() does, but with the
+ *  CORDIC rotation cut to iter stages, for callers that need only a digit
+ *  or two.
+ * PARAMETERS
+ *  z     numeric argument is an angle in radians supplied as a 16 bit
+ *        integer having an implied binary point with 10 bits of
+ *        resolution, or an implied decimal point with three digits of
+ *        resolution.
+ *  iter  CORDIC stages, 0 through NUM_CORDIC_ENTRIES. Larger values are
+ *        taken as NUM_CORDIC_ENTRIES.
+ * RETURN
+ *  Sine and cosine packed as s16_sincos() returns them. With
+ *  NUM_CORDIC_ENTRIES stages they are the s16_sincos() results.
+ * NOTES
+ *  Stage i turns the vector through +-atan(2^-i), so each stage halves
+ *  the angle error left: after iter stages it is about 2^(1-iter) rad at
+ *  most, and the start vector is scaled by the inverse gain for iter
+ *  stages so the length stays 1. The bench example reports the error and
+ *  time per call for each iter. Plain C, with no SSE2 kernel.
+ */
+s32 s16_sincos_p(qm_rad z, u8 iter)
+{
+	qm_cora lc=CORDIC_LC;
+
+	if (iter > NUM_CORDIC_ENTRIES)
+		iter=NUM_CORDIC_ENTRIES;
+	if (iter < sizeof cordic_lc/sizeof cordic_lc[0])
+		lc=cordic_lc[iter];
+	return sincos_stages(z,iter,lc);
+
+} /* End s16_sincos_p () */
+
+/** s16_sincos_n - sine and cosine of arrays of angles
+ * DESCRIPTION
+ *  Computes cosine and sine of phi[i] for 0 <= i < n, storing them in
+ *  separate arrays. cos[i] and sin[i] are the cos and sin members that
+ *  s16_sincos(phi[i]) returns.
+ * PARAMETERS
+ *  phi  angles in radians supplied as 16 bit integers having an implied
+ *       binary point with 10 bits of resolution, or an implied decimal
+ *       point with three digits of resolution.
+ *  cos  receives the n cosines.
+ *  sin  receives the n sines.
+ *  n    number of elements.
+ *  cos and sin are 16 bit integers having an implied binary point with 7
+ *  bits of resolution, or an implied decimal point with two digits of
+ *  resolution, and range from -1.00 through 1.00 inclusive.
+ * RETURN
+ *  None.
+ * NOTES
+ *  x86 builds pick a scalar, SSE2 or AVX2 kernel for the host when the
+ *  library is loaded; the SSE2 and AVX2 kernels run the CORDIC iterations
+ *  on 8 or 16 angles at once.
+ */
+#ifdef S16_DISPATCH
+void s16_sincos_n(const qm_rad *phi, qm_n *cos, qm_n *sin, size_t n)
+	S16_IFUNC(resolve_sincos_n);
+#else
+void s16_sincos_n(const qm_rad *phi, qm_n *cos, qm_n *sin, size_t n)
+{
+	S16_KERNEL(sincos_n)(phi,cos,sin,n);
+
+} /* End s16_sincos_n () */
+#endif
@@ -0,0 +1,435 @@
+/* vi:set ts=4: <-- vi tabstop
+   sqrt.c - evaluate square root and reciprocal square root.
+   Copyright (c) 2014 Bryan Batten <bjbatten@acm.org>
+ */
+#include "cpu.h"		/* for S16_KERNEL () */
+#include "s16math.h"
+
+/* The scalar kernels normalize by an even shift, n = m*4^h with
+   1 <= m < 4, take 1/sqrt(m) from a table indexed by the top 7 bits of m,
+   and run one Newton step from there. The step lands within one of the
+   root, so one compare settles it. */
+#define RSQ_BITS		5				/* fraction bits of the index */
+#define RSQ_SHIFT		14				/* table entries in Q14 */
+#ifdef USE_BINARY_POINT
+#define RSQRT_K			((s32)1<<21)	/* UI^3, 1/sqrt(a) is sqrt(K/a) */
+#define SQRTK			((s32)23170)	/* sqrt(K) = 2^0.5 in Q14 times 2^10 */
+#define SQRTK_SHIFT		4				/* Q14 less 10 */
+#else
+#define RSQRT_K			((s32)1000000)
+#define SQRTK			((s32)1000)		/* sqrt(K) */
+#define SQRTK_SHIFT		0
+#endif
+
+typedef qm_n sqrt_fn(qm_n a);
+typedef void sqrt_n_fn(const qm_n *a, qm_n *r, size_t n);
+
+/* 1/sqrt((i+1/2)/32) in Q14, for 32 <= i < 128 */
+static const u16 rsqtab[96]={
+	16257, 16013, 15779, 15555, 15341, 15135, 14937, 14747, 14564, 14387,
+	14217, 14052, 13894, 13740, 13592, 13448, 13308, 13173, 13042, 12915,
+	12791, 12671, 12554, 12441, 12330, 12223, 12118, 12015, 11916, 11818,
+	11723, 11631, 11540, 11452, 11365, 11281, 11198, 11117, 11038, 10961,
+	10885, 10811, 10738, 10666, 10597, 10528, 10461, 10395, 10330, 10266,
+	10204, 10143, 10082, 10023, 9965, 9908, 9852, 9797, 9743, 9689, 9637,
+	9585, 9534, 9484, 9435, 9386, 9338, 9291, 9245, 9199, 9154, 9110, 9066,
+	9023, 8981, 8939, 8898, 8857, 8817, 8777, 8738, 8700, 8661, 8624, 8587,
+	8550, 8514, 8478, 8443, 8408, 8374, 8340, 8306, 8273, 8240, 8208
+};
+
+/* table index i of 0 < n, with n = (i/32)*4^h and 32 <= i < 128 */
+static u32 rsqindex(u32 n, u8 *h)
+{
+	u8 s;
+
+#ifdef __GNUC__
+	s=(u8)(31-__builtin_clz(n));
+#else
+	for (s=0; n>>s>1; s++)
+		;
+#endif
+	s&=~1;
+	*h=s>>1;
+	return s > RSQ_BITS?n>>(s-RSQ_BITS):n<<(RSQ_BITS-s);
+}
+
+/* floor(sqrt(n)) for 0 < n < 2^23 */
+static s32 isqrt(s32 n)
+{
+	u8 h;
+	u32 i=rsqindex((u32)n,&h);
+	s32 r=rsqtab[i-32],x,d;
+
+	/* sqrt(m) = m/sqrt(m), with m = (2i+1)/64 at the middle of the entry */
+	x=(s32)(((2*i+1)*(u32)r)>>(RSQ_SHIFT+RSQ_BITS+1-h));
+	/* x + (n-x^2)/(2x), with 1/x close to r/2^(14+h) */
+	d=n-x*x;
+	x+=(d*r)>>(RSQ_SHIFT+1+h);
+	if (x*x > n)
+		x--;
+	else if ((x+1)*(x+1) <= n)
+		x++;
+	return x;
+}
+
+/* Babylonian method on the scaled argument, as the reference version
+   does it, stops at the first root r with r-n/r <= 1. That comes to
+   floor(sqrt(n)) rounded up when n >= floor(sqrt(n))^2+floor(sqrt(n)). */
+static qm_n sqrt_c(qm_n a)
+{
+	s32 n,x;
+
+	if (a <= 0)
+		return 0;
+	n=prescale(a);
+	x=isqrt(n);
+	return (qm_n)(x+(n-x*x >= x));
+}
+
+/* sqrt(K/a) rounded to nearest, by the same table and one Newton step
+   for 1/sqrt: r + r*(K-r^2*a)/(2K). */
+static qm_n rsqrt_c(qm_n a)
+{
+	u8 h;
+	u32 i;
+	s32 r,t;
+
+	if (a <= 0)
+		return 0;
+	i=rsqindex((u32)a,&h);
+	r=(rsqtab[i-32]*SQRTK)>>(RSQ_SHIFT+SQRTK_SHIFT+h);
+	t=r*r*a;
+#ifdef USE_BINARY_POINT
+	r+=(r*(RSQRT_K-t))>>22;
+#else
+	r+=(r*(RSQRT_K-t))/(2*RSQRT_K);
+#endif
+	/* nearest: (2r-1)^2*a <= 4K < (2r+1)^2*a */
+	if ((u32)(2*r+1)*(u32)(2*r+1)*(u32)a <= 4*(u32)RSQRT_K)
+		r++;
+	else if ((u32)(2*r-1)*(u32)(2*r-1)*(u32)a > 4*(u32)RSQRT_K)
+		r--;
+	return (qm_n)r;
+}
+
+/* Each array kernel does the elements it can, then hands the rest down. */
+static void sqrt_n_c(const qm_n *a, qm_n *r, size_t n)
+{
+	size_t i;
+
+	for (i=0; i<n; i++)
+		r[i]=sqrt_c(a[i]);
+}
+
+static void rsqrt_n_c(const qm_n *a, qm_n *r, size_t n)
+{
+	size_t i;
+
+	for (i=0; i<n; i++)
+		r[i]=rsqrt_c(a[i]);
+}
+
+#ifdef S16_SSE2
+S16_BEGIN_SSE2
+/* Same result from one hardware square root. n < 2^23, so the truncated
+   double root is exactly floor(sqrt(n)). */
+static qm_n sqrt_sse2(qm_n a)
+{
+	__m128d d;
+	s32 n,f;
+
+	if (a <= 0)
+		return 0;
+	n=prescale(a);
+	d=_mm_cvtsi32_sd(_mm_setzero_pd(),n);
+	f=_mm_cvttsd_si32(_mm_sqrt_sd(d,d));
+	return (qm_n)(f+(n-f*f >= f));
+}
+
+/* sqrt(K/a) in double, rounded half up. A root that is a tie, as for
+   2.56 decimal, is exact in double, and any other is far from one. */
+static qm_n rsqrt_sse2(qm_n a)
+{
+	__m128d d;
+
+	if (a <= 0)
+		return 0;
+	d=_mm_div_sd(_mm_set_sd(RSQRT_K),_mm_set_sd(a));
+	d=_mm_add_sd(_mm_sqrt_sd(d,d),_mm_set_sd(0.5));
+	return (qm_n)_mm_cvttsd_si32(d);
+}
+
+/* Four roots of 32 bit lanes. Scaled arguments are below 2^23, so single
+   precision holds them and their squares are exact: the truncated root
+   is floor(sqrt(n)) as for sqrt_sse2(). Lanes with a <= 0 give 0. */
+static __m128i sqrt4(__m128i a)
+{
+	__m128i n,f;
+	__m128 x,ff;
+
+#ifdef USE_BINARY_POINT
+	n=_mm_slli_epi32(a,NSHIFT);
+#else
+	n=_mm_madd_epi16(a,_mm_set1_epi32(UI));
+#endif
+	x=_mm_cvtepi32_ps(n);
+	f=_mm_cvttps_epi32(_mm_sqrt_ps(x));
+	ff=_mm_cvtepi32_ps(f);
+	/* f+(n-f*f >= f); the compare is all ones where it holds */
+	f=_mm_sub_epi32(f,_mm_castps_si128(
+			_mm_cmpge_ps(_mm_sub_ps(x,_mm_mul_ps(ff,ff)),ff)));
+	return _mm_and_si128(f,_mm_cmpgt_epi32(a,_mm_setzero_si128()));
+}
+
+/* Four reciprocal roots, two doubles at a time, as rsqrt_sse2() */
+static __m128i rsqrt4(__m128i a)
+{
+	const __m128d k=_mm_set1_pd(RSQRT_K),h=_mm_set1_pd(0.5);
+	__m128d d0=_mm_cvtepi32_pd(a);
+	__m128d d1=_mm_cvtepi32_pd(_mm_shuffle_epi32(a,_MM_SHUFFLE(1,0,3,2)));
+	__m128i r0,r1;
+
+	r0=_mm_cvttpd_epi32(_mm_add_pd(_mm_sqrt_pd(_mm_div_pd(k,d0)),h));
+	r1=_mm_cvttpd_epi32(_mm_add_pd(_mm_sqrt_pd(_mm_div_pd(k,d1)),h));
+	return _mm_and_si128(_mm_unpacklo_epi64(r0,r1),
+						 _mm_cmpgt_epi32(a,_mm_setzero_si128()));
+}
+
+/* sign extend eight 16 bit lanes, run f on each half, and pack */
+#define each8(f,x)	_mm_packs_epi32(									\
+		f(_mm_srai_epi32(_mm_unpacklo_epi16((x),(x)),16)),				\
+		f(_mm_srai_epi32(_mm_unpackhi_epi16((x),(x)),16)))
+
+static void sqrt_n_sse2(const qm_n *a, qm_n *r, size_t n)
+{
+	size_t i=0;
+
+	for (; i+8<=n; i+=8)
+		_mm_storeu_si128((__m128i *)(r+i),
+			each8(sqrt4,_mm_loadu_si128((const __m128i *)(a+i))));
+	sqrt_n_c(a+i,r+i,n-i);
+}
+
+static void rsqrt_n_sse2(const qm_n *a, qm_n *r, size_t n)
+{
+	size_t i=0;
+
+	for (; i+8<=n; i+=8)
+		_mm_storeu_si128((__m128i *)(r+i),
+			each8(rsqrt4,_mm_loadu_si128((const __m128i *)(a+i))));
+	rsqrt_n_c(a+i,r+i,n-i);
+}
+S16_END
+#endif /* S16_SSE2 */
+
+#ifdef S16_AVX2
+S16_BEGIN_AVX2
+/* Eight lanes; same steps as sqrt4(). */
+static __m256i sqrt8(__m256i a)
+{
+	__m256i n,f;
+	__m256 x,ff;
+
+#ifdef USE_BINARY_POINT
+	n=_mm256_slli_epi32(a,NSHIFT);
+#else
+	n=_mm256_mullo_epi32(a,_mm256_set1_epi32(UI));
+#endif
+	x=_mm256_cvtepi32_ps(n);
+	f=_mm256_cvttps_epi32(_mm256_sqrt_ps(x));
+	ff=_mm256_cvtepi32_ps(f);
+	f=_mm256_sub_epi32(f,_mm256_castps_si256(_mm256_cmp_ps(
+			_mm256_sub_ps(x,_mm256_mul_ps(ff,ff)),ff,_CMP_GE_OQ)));
+	return _mm256_and_si256(f,_mm256_cmpgt_epi32(a,_mm256_setzero_si256()));
+}
+
+/* Eight lanes, four doubles at a time, as rsqrt4() */
+static __m256i rsqrt8(__m256i a)
+{
+	const __m256d k=_mm256_set1_pd(RSQRT_K),h=_mm256_set1_pd(0.5);
+	__m256d d0=_mm256_cvtepi32_pd(_mm256_castsi256_si128(a));
+	__m256d d1=_mm256_cvtepi32_pd(_mm256_extracti128_si256(a,1));
+	__m128i r0,r1;
+
+	r0=_mm256_cvttpd_epi32(
+			_mm256_add_pd(_mm256_sqrt_pd(_mm256_div_pd(k,d0)),h));
+	r1=_mm256_cvttpd_epi32(
+			_mm256_add_pd(_mm256_sqrt_pd(_mm256_div_pd(k,d1)),h));
+	return _mm256_and_si256(
+			_mm256_inserti128_si256(_mm256_castsi128_si256(r0),r1,1),
+			_mm256_cmpgt_epi32(a,_mm256_setzero_si256()));
+}
+
+/* sixteen 16 bit lanes: widen each half, run f, and narrow; packs works
+   within 128 bit lanes, so the halves are permuted back into order */
+#define each16(f,x)	_mm256_permute4x64_epi64(_mm256_packs_epi32(			\
+		f(_mm256_cvtepi16_epi32(_mm256_castsi256_si128(x))),				\
+		f(_mm256_cvtepi16_epi32(_mm256_extracti128_si256((x),1)))),			\
+		_MM_SHUFFLE(3,1,2,0))
+
+static void sqrt_n_avx2(const qm_n *a, qm_n *r, size_t n)
+{
+	size_t i=0;
+
+	for (; i+16<=n; i+=16) {
+		__m256i x=_mm256_loadu_si256((const __m256i *)(a+i));
+
+		_mm256_storeu_si256((__m256i *)(r+i),each16(sqrt8,x));
+	}
+	sqrt_n_sse2(a+i,r+i,n-i);
+}
+
+static void rsqrt_n_avx2(const qm_n *a, qm_n *r, size_t n)
+{
+	size_t i=0;
+
+	for (; i+16<=n; i+=16) {
+		__m256i x=_mm256_loadu_si256((const __m256i *)(a+i));
+
+		_mm256_storeu_si256((__m256i *)(r+i),each16(rsqrt8,x));
+	}
+	rsqrt_n_sse2(a+i,r+i,n-i);
+}
+S16_END
+#endif /* S16_AVX2 */
+
+#ifdef S16_DISPATCH
+static sqrt_fn *resolve_sqrt(void)
+{
+	return S16_KERNEL_SSE2(sqrt);
+}
+
+static sqrt_fn *resolve_rsqrt(void)
+{
+	return S16_KERNEL_SSE2(rsqrt);
+}
+
+static sqrt_n_fn *resolve_sqrt_n(void)
+{
+	return S16_KERNEL(sqrt_n);
+}
+
+static sqrt_n_fn *resolve_rsqrt_n(void)
+{
+	return S16_KERNEL(rsqrt_n);
+}
+#endif
+
+/** s16_sqrt - evaluate square root
+ * DESCRIPTION
+ *  Evaluate a^(1/2) and return principal root.
+ * PARAMETER
+ *  The parameter is supplied as a 16 bit integer having an implied binary
+ *  point with 7 bits of resolution, or an implied decimal point with two
+ *  digits of resolution.
+ *  a  number to find square root of.
+ * RETURN
+ *  The root is returned as a 16 bit integer having an implied binary
+ *  point with 7 bits of resolution, or an implied decimal point with two
+ *  digits of resolution.
+ *
+ *  If the square root of a negative number is requested, the function
+ *  returns zero.
+ * NOTES
+ *  Replaces the s16math library version with the same results. x86 builds
+ *  pick a table seed and one Newton step or, where SSE2 is available, one
+ *  hardware square root, when the library is loaded. Neither loops.
+ */
+#ifdef S16_DISPATCH
+qm_n s16_sqrt(qm_n a) S16_IFUNC(resolve_sqrt);
+#else
+qm_n s16_sqrt(qm_n a)
+{
+	return S16_KERNEL_SSE2(sqrt)(a);
+
+} /* End s16_sqrt () */
+#endif
+
+/** s16_rsqrt - evaluate reciprocal square root
+ * DESCRIPTION
+ *  Evaluate 1/a^(1/2), for 0 < a.
+ * PARAMETER
+ *  The parameter is supplied as a 16 bit integer having an implied binary
+ *  point with 7 bits of resolution, or an implied decimal point with two
+ *  digits of resolution.
+ *  a  number to find reciprocal square root of.
+ * RETURN
+ *  The reciprocal root rounded to nearest, in the same format as a: at
+ *  most 11.314 (10.00 decimal), for the least positive a.
+ *
+ *  If a <= 0, the function returns zero, as s16_div(UI,s16_sqrt(a))
+ *  does.
+ * NOTES
+ *  One call in place of s16_div(UI,s16_sqrt(a)), which rounds twice; the
+ *  scalar kernel normalizes a by an even shift, seeds from a 96 entry
+ *  table and takes one Newton step, with no division. Where SSE2 is
+ *  available, one hardware division and square root are used instead.
+ */
+#ifdef S16_DISPATCH
+qm_n s16_rsqrt(qm_n a) S16_IFUNC(resolve_rsqrt);
+#else
+qm_n s16_rsqrt(qm_n a)
+{
+	return S16_KERNEL_SSE2(rsqrt)(a);
+
+} /* End s16_rsqrt () */
+#endif
+
+/** s16_sqrt_n - square roots of an array
+ * DESCRIPTION
+ *  Computes r[i]=a[i]^(1/2) for 0 <= i < n, with the results of
+ *  s16_sqrt().
+ * PARAMETERS
+ *  a  numbers supplied as 16 bit integers having an implied binary point
+ *     with 7 bits of resolution, or an implied decimal point with two
+ *     digits of resolution.
+ *  r  receives the n roots, same format as a. r may be the same array as
+ *     a, but must not otherwise overlap it.
+ *  n  number of elements.
+ * RETURN
+ *  None. Negative elements give zero.
+ * NOTES
+ *  x86 builds pick a scalar, SSE2 or AVX2 kernel for the host when the
+ *  library is loaded; the SSE2 and AVX2 kernels take 8 or 16 elements per
+ *  step, with single precision square roots, which are exact here.
+ */
+#ifdef S16_DISPATCH
+void s16_sqrt_n(const qm_n *a, qm_n *r, size_t n) S16_IFUNC(resolve_sqrt_n);
+#else
+void s16_sqrt_n(const qm_n *a, qm_n *r, size_t n)
+{
+	S16_KERNEL(sqrt_n)(a,r,n);
+
+} /* End s16_sqrt_n () */
+#endif
+
+/** s16_rsqrt_n - reciprocal square roots of an array
+ * DESCRIPTION
+ *  Computes r[i]=1/a[i]^(1/2) for 0 <= i < n, with the results of
+ *  s16_rsqrt(). Scaling each component of a vector by s16_rsqrt_n() of
+ *  its squared length normalizes it, as for accelerometer and
+ *  magnetometer samples.
+ * PARAMETERS
+ *  a  numbers supplied as 16 bit integers having an implied binary point
+ *     with 7 bits of resolution, or an implied decimal point with two
+ *     digits of resolution.
+ *  r  receives the n reciprocal roots, same format as a. r may be the
+ *     same array as a, but must not otherwise overlap it.
+ *  n  number of elements.
+ * RETURN
+ *  None. Elements <= 0 give zero.
+ * NOTES
+ *  x86 builds pick a scalar, SSE2 or AVX2 kernel for the host when the
+ *  library is loaded; the SSE2 and AVX2 kernels take 8 or 16 elements per
+ *  step, in double precision.
+ */
+#ifdef S16_DISPATCH
+void s16_rsqrt_n(const qm_n *a, qm_n *r, size_t n)
+	S16_IFUNC(resolve_rsqrt_n);
+#else
+void s16_rsqrt_n(const qm_n *a, qm_n *r, size_t n)
+{
+	S16_KERNEL(rsqrt_n)(a,r,n);
+
+} /* End s16_rsqrt_n () */
+#endif